@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2020 Thomas AUBERT <aubert.thms@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name ``Thomas AUBERT'' nor the name of any other
+ *    contributor may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 
+ * uCosmDev IS PROVIDED BY Thomas AUBERT ``AS IS'' AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL Thomas AUBERT OR ANY OTHER CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+// Scaling of the TaskHandler with the task count :
+//
+//	g++ -std=c++14 -O2 -I<uCoSM>/src bench/task-scale.cc -o task-scale
+//	./task-scale
+//
+// measures per task : creation, deletion, a cycle with every task ready,
+// a cycle with 1% of the tasks ready (Delay, AoS and SoA), and a cycle over
+// a handler whose slots are 1% occupied.
+
+#include <chrono>
+#include <cstdio>
+
+#include "kernel.h"
+
+
+
+
+using namespace ucosm_modules;
+
+static tick_t sTick = 0;
+
+tick_t getTick(){ return sTick; }
+
+tick_t (*SysKernelData::sGetTick)() = &getTick;
+
+static uint32_t sCallCount = 0;
+
+
+
+template<typename task_modules, uint32_t task_count>
+class Bench : public TaskHandler<Bench<task_modules, task_count>, task_modules, task_count>
+{
+public:
+
+	using handler_t = TaskHandler<Bench<task_modules, task_count>, task_modules, task_count>;
+	using TaskHandle = typename handler_t::TaskHandle;
+
+	void process(){ sCallCount++; }
+
+	TaskHandle mHandles[task_count];
+};
+
+
+
+static double getNs(std::chrono::steady_clock::time_point inStart, uint32_t inCount)
+{
+	std::chrono::duration<double, std::nano> d = std::chrono::steady_clock::now() - inStart;
+	return d.count() / inCount;
+}
+
+// delays the tasks but one in inEvery
+template<typename bench_t>
+static void setDelays(bench_t &ioBench, uint32_t inCount, uint32_t inEvery, bool inIsSoa);
+
+template<typename bench_t>
+static void setDelay(bench_t &ioBench, uint32_t i, tick_t inDelay, std::false_type)
+{
+	ioBench.mHandles[i]->setDelay(inDelay);
+}
+
+template<typename bench_t>
+static void setDelay(bench_t &ioBench, uint32_t i, tick_t inDelay, std::true_type)
+{
+	ioBench.mHandles[i]->template get<Delay>()->setDelay(inDelay);
+}
+
+template<typename task_modules, uint32_t task_count, typename is_soa>
+static void run(const char *inName, Bench<task_modules, task_count> &ioBench)
+{
+	using bench_t = Bench<task_modules, task_count>;
+	const uint32_t cycles = 200;
+
+	auto start = std::chrono::steady_clock::now();
+	for(uint32_t i=0 ; i<task_count ; i++)
+	{
+		ioBench.createTask(&bench_t::process, &ioBench.mHandles[i]);
+	}
+	double create = getNs(start, task_count);
+
+	sCallCount = 0;
+	start = std::chrono::steady_clock::now();
+	for(uint32_t c=0 ; c<cycles ; c++){ ioBench.schedule(); }
+	double allReady = getNs(start, cycles*task_count);
+
+	// 1% of the tasks ready
+	for(uint32_t i=0 ; i<task_count ; i++)
+	{
+		setDelay(ioBench, i, (i%100) ? 1000000 : 0, is_soa());
+	}
+	start = std::chrono::steady_clock::now();
+	for(uint32_t c=0 ; c<cycles ; c++){ ioBench.schedule(); }
+	double fewReady = getNs(start, cycles*task_count);
+
+	start = std::chrono::steady_clock::now();
+	for(uint32_t i=0 ; i<task_count ; i++)
+	{
+		ioBench.deleteTask(ioBench.mHandles[i]);
+	}
+	double del = getNs(start, task_count);
+
+	// 1% of the slots occupied
+	for(uint32_t i=0 ; i<task_count ; i+=100)
+	{
+		ioBench.createTask(&bench_t::process, &ioBench.mHandles[i]);
+	}
+	start = std::chrono::steady_clock::now();
+	for(uint32_t c=0 ; c<cycles ; c++){ ioBench.schedule(); }
+	double sparse = getNs(start, cycles*task_count);
+
+	printf("%-26s %6u tasks  index %zu byte(s) | create %6.1f  delete %6.1f  all ready %6.1f  "
+		"1%% ready %6.1f  1%% occupied %6.2f  ns/task\n", 
+		inName, task_count, sizeof(typename IndexType<task_count>::type), 
+		create, del, allReady, fewReady, sparse);
+}
+
+
+
+static Bench<Modules<Delay>, 200> sSmallAos;
+static Bench<Modules<Delay>, 10000> sLargeAos;
+static Bench<SoaModules<Delay>, 200> sSmallSoa;
+static Bench<SoaModules<Delay>, 10000> sLargeSoa;
+static Bench<SoaModules<Delay>, 60000> sHugeSoa;
+
+int main()
+{
+	run<Modules<Delay>, 200, std::false_type>("Modules<Delay>", sSmallAos);
+	run<Modules<Delay>, 10000, std::false_type>("Modules<Delay>", sLargeAos);
+	run<SoaModules<Delay>, 200, std::true_type>("SoaModules<Delay>", sSmallSoa);
+	run<SoaModules<Delay>, 10000, std::true_type>("SoaModules<Delay>", sLargeSoa);
+	run<SoaModules<Delay>, 60000, std::true_type>("SoaModules<Delay>", sHugeSoa);
+	return 0;
+}
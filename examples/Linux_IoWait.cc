@@ -0,0 +1,104 @@
+#include <iostream>
+#include <unistd.h>
+
+#include "/uCoSM/kernel.h"
+
+#include "/uCoSM/modules.h"
+
+// defines the time base (CLOCK_MONOTONIC) and the IoWait module
+#include "/uCoSM/linux/port.h"
+
+
+
+
+
+
+
+
+
+using namespace ucosm_modules;
+
+
+
+
+
+
+
+
+
+// defines the type of task properties, i.e. status, fd readiness and delay handling
+using task_module_t = Modules< Status, IoWait, Delay >; 
+
+
+// EchoProcess echoes the standard input and prints a heartbeat every second,
+// the process sleeps in between
+
+class EchoProcess : public TaskHandler< EchoProcess, task_module_t, 2 >
+{
+	public:
+
+		EchoProcess()
+		{
+			TaskHandle input;
+
+			// create tasks
+			createTask(&EchoProcess::inputProcess, &input);
+
+			createTask(&EchoProcess::heartbeatProcess);
+
+			// inputProcess is executed when the standard input is readable
+			input->setWait(STDIN_FILENO);
+		}
+
+		void inputProcess()
+		{
+			char buffer[64];
+			ssize_t n = read(STDIN_FILENO, buffer, sizeof(buffer));
+			if(n <= 0)
+			{
+				// end of file
+				thisTaskHandle()->clearWait();
+				thisTaskHandle()->setStatus(Status::eSuspended, true);
+				return;
+			}
+			std::cout.write(buffer, n);
+		}
+
+		void heartbeatProcess()
+		{
+			std::cout << "heartbeat" << std::endl;
+			thisTaskHandle()->setDelay(1000); // will restart in 1 s
+		}
+	
+};
+
+
+
+
+
+
+
+
+
+
+
+Kernel<Modules<>, 1> kernel;
+
+
+EchoProcess echoProcess;
+
+int main()
+{
+
+	kernel.addHandler(&echoProcess);
+		
+	while(1)
+	{
+		kernel.schedule();
+
+		// sleeps until the next delay or the standard input readiness
+		ucosm_linux::waitForEvents(kernel);
+	}
+	
+	return 0;
+}
@@ -0,0 +1,469 @@
+/*
+ * Copyright (C) 2020 Thomas AUBERT <aubert.thms@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name ``Thomas AUBERT'' nor the name of any other
+ *    contributor may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 
+ * uCosmDev IS PROVIDED BY Thomas AUBERT ``AS IS'' AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL Thomas AUBERT OR ANY OTHER CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <atomic>
+
+#include "modules.h"
+
+//-----------------------------  Atomic Task Modules  ---------------------------
+
+// Task modules shared with an interrupt, another thread or another handler :
+// their state is held in std::atomic, this header is included where they are used
+// so that the core modules do not depend on <atomic>.
+//    - Dataflow, PingPongBuffer, StreamBuffer
+
+
+namespace ucosm_modules
+{
+
+
+
+
+
+// task graph node : the task is ready when all its inputs have completed
+// since its last execution, a task without input is a source of the graph.
+// The arrivals are recorded in an atomic mask, the inputs and outputs can
+// belong to different TaskHandlers.
+template<uint8_t max_inputs, uint8_t max_outputs>
+struct Dataflow
+{
+	static_assert(max_inputs > 0 && max_inputs <= 32, "Dataflow input count must be within [1,32]");
+
+	// adds inInput as a predecessor of this task
+	bool addInput(Dataflow *inInput)
+	{
+		if(!inInput || inInput == this){ return false; }
+
+		uint8_t i = 0;
+		while(i < max_inputs && mInputs[i]){ i++; }
+		if(i == max_inputs){ return false; }
+
+		if(!inInput->addOutput(this, i)){ return false; }
+
+		mInputs[i] = inInput;
+		mArrived.fetch_and(static_cast<mask_t>(~getInputBit(i)), std::memory_order_relaxed);
+		return true;
+	}
+
+	// removes inInput from the predecessors of this task
+	void removeInput(Dataflow *inInput)
+	{
+		for(uint8_t i=0 ; i<max_inputs ; i++)
+		{
+			if(mInputs[i] == inInput)
+			{
+				inInput->removeOutput(this);
+				unlinkInput(i);
+			}
+		}
+	}
+
+	// true when all the inputs have completed since the last execution
+	bool isInputReady() const
+	{
+		const mask_t required = getRequiredMask();
+		return (mArrived.load(std::memory_order_acquire) & required) == required;
+	}
+
+	static const uint8_t snapshot_id = SnapshotWriter::eDataflow;
+
+	// required and arrived inputs masks
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put32(getRequiredMask());
+		ioWriter.put32(mArrived.load(std::memory_order_relaxed));
+	}
+
+protected:
+
+	template<typename>
+	void init()
+	{
+		for(uint8_t i=0 ; i<max_inputs ; i++){ mInputs[i] = nullptr; }
+		for(uint8_t i=0 ; i<max_outputs ; i++){ mOutputs[i] = nullptr; }
+		mArrived.store(0, std::memory_order_relaxed);
+	}
+	bool isExeReady() const { return isInputReady(); }
+	bool isDelReady() const { return true; }
+	void makePreExe()
+	{
+		// consumes the round : arrivals during the execution count for the next one
+		mArrived.fetch_and(static_cast<mask_t>(~getRequiredMask()), std::memory_order_acq_rel);
+	}
+	void makePostExe()
+	{
+		for(uint8_t i=0 ; i<max_outputs ; i++)
+		{
+			if(mOutputs[i])
+			{
+				mOutputs[i]->mArrived.fetch_or(getInputBit(mOutputSlots[i]), std::memory_order_release);
+			}
+		}
+	}
+	void makePreDel()
+	{
+		for(uint8_t i=0 ; i<max_inputs ; i++)
+		{
+			if(mInputs[i])
+			{
+				mInputs[i]->removeOutput(this);
+				unlinkInput(i);
+			}
+		}
+		for(uint8_t i=0 ; i<max_outputs ; i++)
+		{
+			if(mOutputs[i])
+			{
+				mOutputs[i]->unlinkInput(mOutputSlots[i]);
+				mOutputs[i] = nullptr;
+			}
+		}
+	}
+
+private:
+
+	using mask_t = typename FlagWordType<max_inputs>::type;
+
+	static mask_t getInputBit(uint8_t inSlot){ return static_cast<mask_t>(1) << inSlot; }
+
+	mask_t getRequiredMask() const
+	{
+		mask_t required = 0;
+		for(uint8_t i=0 ; i<max_inputs ; i++)
+		{
+			if(mInputs[i]){ required |= getInputBit(i); }
+		}
+		return required;
+	}
+
+	bool addOutput(Dataflow *inOutput, uint8_t inSlot)
+	{
+		for(uint8_t i=0 ; i<max_outputs ; i++)
+		{
+			if(!mOutputs[i])
+			{
+				mOutputs[i] = inOutput;
+				mOutputSlots[i] = inSlot;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void removeOutput(Dataflow *inOutput)
+	{
+		for(uint8_t i=0 ; i<max_outputs ; i++)
+		{
+			if(mOutputs[i] == inOutput){ mOutputs[i] = nullptr; }
+		}
+	}
+
+	void unlinkInput(uint8_t inSlot)
+	{
+		mInputs[inSlot] = nullptr;
+		mArrived.fetch_and(static_cast<mask_t>(~getInputBit(inSlot)), std::memory_order_relaxed);
+	}
+
+	Dataflow *mInputs[max_inputs];
+	Dataflow *mOutputs[max_outputs];
+	uint8_t mOutputSlots[max_outputs];
+	std::atomic<mask_t> mArrived;
+};
+
+
+
+
+
+
+// banks of a buffer exchanged between a producer and a consumer without copy :
+// the producer fills the back bank and publishes it, the consumer reads the front bank in place.
+//  - 2 banks : the producer and the consumer are tasks of the scheduler (ping-pong),
+//    the front bank is valid until the consumer returns
+//  - 3 banks : the producer is an interrupt or another thread (triple buffering),
+//    the front bank is valid until the next acquireFront()
+template<typename buffer_t, uint16_t size, uint8_t bank_count = 2> 
+struct PingPongBuffer
+{
+
+	static_assert(bank_count == 2 || bank_count == 3, "PingPongBuffer has 2 or 3 banks");
+
+	static const uint8_t snapshot_id = SnapshotWriter::ePingPongBuffer;
+
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put8(mFront);
+		ioWriter.put8(mBack);
+		ioWriter.put8(mState.load(std::memory_order_relaxed));
+	}
+
+	// producer side : bank being filled
+	buffer_t *getBackBank()
+	{
+		return mBanks[mBack];
+	}
+
+	// makes the back bank the next front bank, the producer continues in another bank
+	void publish()
+	{
+		if(bank_count == 2)
+		{
+			mState.store(mBack | kFresh, std::memory_order_release);
+			mBack ^= 1;
+		}else{
+			mBack = mState.exchange(mBack | kFresh, std::memory_order_acq_rel) & kIndexMask;
+		}
+	}
+
+	// consumer side : takes the last published bank as front bank,
+	// returns false if no bank was published since the previous call
+	bool acquireFront()
+	{
+		if(!(mState.load(std::memory_order_relaxed) & kFresh))
+		{
+			return false;
+		}
+		if(bank_count == 2)
+		{
+			mFront = mState.fetch_and(kIndexMask, std::memory_order_acquire) & kIndexMask;
+		}else{
+			mFront = mState.exchange(mFront, std::memory_order_acq_rel) & kIndexMask;
+		}
+		return true;
+	}
+
+	const buffer_t *getFrontBank() const
+	{
+		return mBanks[mFront];
+	}
+
+	uint16_t getBankSize() const
+	{
+		return size;
+	}
+
+protected:
+
+	template<typename derived_t>
+	void init()
+	{
+		mBack = 0;
+		mFront = 1;
+		mState.store(bank_count-1, std::memory_order_relaxed);
+	}
+
+	bool isExeReady() const { return true; }
+	bool isDelReady() const { return true; } 
+	void makePreExe(){}
+	void makePreDel(){}
+	void makePostExe(){}
+
+private:
+
+	static const uint8_t kFresh = 0x80;
+	static const uint8_t kIndexMask = 0x7F;
+
+	buffer_t mBanks[bank_count][size];
+
+	uint8_t mBack;
+	uint8_t mFront;
+
+	// last published bank (2 banks) or bank between the producer and the consumer (3 banks),
+	// kFresh : not acquired yet
+	std::atomic<uint8_t> mState;
+};
+
+
+
+
+
+
+// byte stream ring, written and read in place :
+//  - the producer (task, interrupt, DMA) gets the contiguous free space with prepareWrite()
+//    and makes the written bytes readable with commit()
+//  - the owner task reads the contiguous readable bytes with peekRead() and releases them
+//    with consume(), the bytes following the end of the ring are read by the next peekRead()
+// The owner task is ready once the fill level reaches the trigger level (1 byte by default)
+// or when the producer flushes the stream : it runs once per chunk instead of once per byte.
+// One producer and one consumer, size is a power of two.
+template<uint16_t size>
+struct StreamBuffer
+{
+
+	static_assert(size && !(size & (size-1)) && size <= 0x8000, "StreamBuffer size must be a power of two");
+
+	static const uint8_t snapshot_id = SnapshotWriter::eStreamBuffer;
+
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put16(getCount());
+		ioWriter.put16(mTriggerLevel);
+		ioWriter.put16(size);
+	}
+
+	// producer side
+
+	// contiguous free space, inMaxSize bytes at most (0 : no limit)
+	Span<uint8_t> prepareWrite(uint16_t inMaxSize = 0)
+	{
+		const uint16_t head = mHead.load(std::memory_order_relaxed);
+		const uint16_t offset = head & (size-1);
+		uint16_t n = getFree();
+		if(n > size - offset){ n = size - offset; }
+		if(inMaxSize && n > inMaxSize){ n = inMaxSize; }
+		return Span<uint8_t>{&mBuffer[offset], n};
+	}
+
+	// makes inSize bytes written in the prepared span readable
+	void commit(uint16_t inSize)
+	{
+		const uint16_t free = getFree();
+		mHead.store(mHead.load(std::memory_order_relaxed) + ((inSize < free) ? inSize : free), std::memory_order_release);
+	}
+
+	// copies inData, returns the number of bytes written
+	uint16_t write(const uint8_t *inData, uint16_t inSize)
+	{
+		uint16_t written = 0;
+		while(written < inSize)
+		{
+			Span<uint8_t> span = prepareWrite(inSize - written);
+			if(span.isEmpty()){ break; }
+			memcpy(span.data, inData + written, span.size);
+			commit(span.size);
+			written += span.size;
+		}
+		return written;
+	}
+
+	// the owner task is ready even below the trigger level, i.e. end of a frame
+	void flush()
+	{
+		mFlush.store(true, std::memory_order_release);
+	}
+
+	uint16_t getFree() const
+	{
+		return size - getCount();
+	}
+
+	// consumer side
+
+	// contiguous readable bytes
+	Span<const uint8_t> peekRead() const
+	{
+		const uint16_t tail = mTail.load(std::memory_order_relaxed);
+		const uint16_t offset = tail & (size-1);
+		uint16_t n = getCount();
+		if(n > size - offset){ n = size - offset; }
+		return Span<const uint8_t>{&mBuffer[offset], n};
+	}
+
+	// releases inSize bytes read in place
+	void consume(uint16_t inSize)
+	{
+		const uint16_t count = getCount();
+		mTail.store(mTail.load(std::memory_order_relaxed) + ((inSize < count) ? inSize : count), std::memory_order_release);
+	}
+
+	// copies up to inSize bytes, returns the number of bytes read
+	uint16_t read(uint8_t *outData, uint16_t inSize)
+	{
+		uint16_t done = 0;
+		while(done < inSize)
+		{
+			Span<const uint8_t> span = peekRead();
+			if(span.isEmpty()){ break; }
+			const uint16_t n = (span.size < inSize - done) ? span.size : inSize - done;
+			memcpy(outData + done, span.data, n);
+			consume(n);
+			done += n;
+		}
+		return done;
+	}
+
+	uint16_t getCount() const
+	{
+		return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire);
+	}
+
+	// fill level making the owner task ready, 0 : always ready,
+	// clamped to size : a full ring always makes the task ready
+	void setTriggerLevel(uint16_t inLevel)
+	{
+		mTriggerLevel = (inLevel < size) ? inLevel : size;
+	}
+
+	uint16_t getTriggerLevel() const
+	{
+		return mTriggerLevel;
+	}
+
+protected:
+
+	template<typename derived_t>
+	void init()
+	{
+		mHead.store(0, std::memory_order_relaxed);
+		mTail.store(0, std::memory_order_relaxed);
+		mFlush.store(false, std::memory_order_relaxed);
+		mTriggerLevel = 1;
+	}
+
+	bool isExeReady() const
+	{
+		return getCount() >= mTriggerLevel || mFlush.load(std::memory_order_acquire);
+	}
+
+	bool isDelReady() const { return true; } 
+	void makePreExe()
+	{
+		mFlush.store(false, std::memory_order_relaxed);
+	}
+	void makePreDel(){}
+	void makePostExe(){}
+
+private:
+
+	uint8_t mBuffer[size];
+
+	// free running counters : written by the producer and by the consumer
+	std::atomic<uint16_t> mHead;
+	std::atomic<uint16_t> mTail;
+
+	std::atomic<bool> mFlush;
+
+	uint16_t mTriggerLevel;
+};
+
+
+
+
+} // end of task_traits namespace
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2020 Thomas AUBERT <aubert.thms@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name ``Thomas AUBERT'' nor the name of any other
+ *    contributor may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 
+ * uCosmDev IS PROVIDED BY Thomas AUBERT ``AS IS'' AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL Thomas AUBERT OR ANY OTHER CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#pragma once
+
+#include "uscosm-sys-data.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+
+// Readiness of deadline based modules (Delay, Periodic) :
+// compares the deadlines of a whole task array against the tick in one pass
+// and sets the bit i of ioMask[i/32] when the deadline i is reached.
+// The deadlines are read from inDeadlines with a stride of inStride ticks,
+// the comparison is wraparound safe (see isTickReached).
+// Vectorized for AVX2, SSE2 and NEON on stride 1 and 2, scalar otherwise.
+
+
+
+inline void deadlineMaskScalar(const tick_t *inDeadlines, uint32_t inStride, 
+	uint32_t inFrom, uint32_t inCount, tick_t inTick, uint32_t *ioMask)
+{
+	for(uint32_t i=inFrom ; i<inCount ; i++)
+	{
+		if(isTickReached(inTick, inDeadlines[i*inStride]))
+		{
+			ioMask[i/32] |= (1UL<<(i%32));
+		}
+	}
+}
+
+
+
+#if defined(__AVX2__)
+
+static const uint32_t deadline_lanes = 8;
+
+// bit set for each reached deadline of the 8 lanes
+inline uint32_t deadlineLanes(const tick_t *inDeadlines, uint32_t inStride, __m256i inTick)
+{
+	__m256i deadlines;
+	if(inStride == 1)
+	{
+		deadlines = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inDeadlines));
+	}else{
+		__m256 a = _mm256_loadu_ps(reinterpret_cast<const float *>(inDeadlines));
+		__m256 b = _mm256_loadu_ps(reinterpret_cast<const float *>(inDeadlines+8));
+		// even lanes, then restore the order of the 128 bits halves
+		__m256 even = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+		deadlines = _mm256_permute4x64_epi64(_mm256_castps_si256(even), _MM_SHUFFLE(3,1,2,0));
+	}
+	// sign bit set : deadline not reached
+	__m256i diff = _mm256_sub_epi32(inTick, deadlines);
+	return (~_mm256_movemask_ps(_mm256_castsi256_ps(diff)))&0xFF;
+}
+
+#define DEADLINE_TICK_T __m256i
+#define DEADLINE_SET_TICK(t) _mm256_set1_epi32(static_cast<int>(t))
+
+#elif defined(__SSE2__)
+
+static const uint32_t deadline_lanes = 4;
+
+// bit set for each reached deadline of the 4 lanes
+inline uint32_t deadlineLanes(const tick_t *inDeadlines, uint32_t inStride, __m128i inTick)
+{
+	__m128i deadlines;
+	if(inStride == 1)
+	{
+		deadlines = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inDeadlines));
+	}else{
+		__m128 a = _mm_loadu_ps(reinterpret_cast<const float *>(inDeadlines));
+		__m128 b = _mm_loadu_ps(reinterpret_cast<const float *>(inDeadlines+4));
+		deadlines = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0)));
+	}
+	// sign bit set : deadline not reached
+	__m128i diff = _mm_sub_epi32(inTick, deadlines);
+	return (~_mm_movemask_ps(_mm_castsi128_ps(diff)))&0xF;
+}
+
+#define DEADLINE_TICK_T __m128i
+#define DEADLINE_SET_TICK(t) _mm_set1_epi32(static_cast<int>(t))
+
+#elif defined(__ARM_NEON)
+
+static const uint32_t deadline_lanes = 4;
+
+// bit set for each reached deadline of the 4 lanes
+inline uint32_t deadlineLanes(const tick_t *inDeadlines, uint32_t inStride, uint32x4_t inTick)
+{
+	uint32x4_t deadlines;
+	if(inStride == 1)
+	{
+		deadlines = vld1q_u32(inDeadlines);
+	}else{
+		deadlines = vld2q_u32(inDeadlines).val[0];
+	}
+	// sign bit set : deadline not reached
+	uint32x4_t late = vshrq_n_u32(vsubq_u32(inTick, deadlines), 31);
+	const int32_t shifts[4] = {0, 1, 2, 3};
+	uint32x4_t bits = vshlq_u32(late, vld1q_s32(shifts));
+#if defined(__aarch64__)
+	uint32_t notReached = vaddvq_u32(bits);
+#else
+	uint32x2_t sum = vpadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+	uint32_t notReached = vget_lane_u32(vpadd_u32(sum, sum), 0);
+#endif
+	return (~notReached)&0xF;
+}
+
+#define DEADLINE_TICK_T uint32x4_t
+#define DEADLINE_SET_TICK(t) vdupq_n_u32(t)
+
+#endif
+
+
+
+inline void deadlineMask(const tick_t *inDeadlines, uint32_t inStride, uint32_t inCount, 
+	tick_t inTick, uint32_t *ioMask)
+{
+	uint32_t i = 0;
+
+#if defined(DEADLINE_TICK_T)
+	if(inStride <= 2)
+	{
+		DEADLINE_TICK_T tick = DEADLINE_SET_TICK(inTick);
+		// the lanes never straddle two mask words
+		for( ; i+deadline_lanes <= inCount ; i+=deadline_lanes)
+		{
+			ioMask[i/32] |= deadlineLanes(&inDeadlines[i*inStride], inStride, tick) << (i%32);
+		}
+	}
+#endif
+
+	deadlineMaskScalar(inDeadlines, inStride, i, inCount, inTick, ioMask);
+}
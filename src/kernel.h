@@ -36,14 +36,44 @@
 
 
 
-template<typename handler_t, index_t max_handler_count> 
+// kernel statistics over a report period, see Kernel::setStatsPeriod()
+struct KernelStats
+{
+	cycle_t cycles;			// kernel cycles
+	cycle_t idleCycles;		// cycles without task execution
+	tick_t busy;			// time spent in the cycles with task execution
+	tick_t longestCycle;	// longest cycle duration
+	tick_t period;			// actual duration of the period
+
+	// percentage of the period spent executing tasks
+	uint8_t getLoadPercent() const
+	{
+		return period ? static_cast<uint8_t>((static_cast<uint64_t>(busy)*100)/period) : 0;
+	}
+
+	// percentage of the cycles without task execution
+	uint8_t getIdlePercent() const
+	{
+		return cycles ? static_cast<uint8_t>((static_cast<uint64_t>(idleCycles)*100)/cycles) : 0;
+	}
+};
+
+
+
+
+// max_handler_count : max number of simultaneous handlers
+// index_type : type of the handler indexes, by default the smallest one addressing max_handler_count slots
+template<typename handler_t, uint32_t max_handler_count, 
+	typename index_type = typename IndexType<max_handler_count>::type> 
 class Kernel : public iScheduler
 {
 
 
 public:
 
-	Kernel() : mHandlerCount(0), mIdleTask(nullptr)
+	Kernel() : mHandlerCount(0), mIdleTask(nullptr), mStats(), mLastStats(), 
+		mStatsPeriod(0), mStatsStart(0), mStatsReport(nullptr),
+		mOverloadThreshold(0), mRecoveryCycles(0), mUnderloadCycles(0), mOverloadNotify(nullptr)
 	{}
 
 	bool addHandler(iScheduler *inHandler)
@@ -57,7 +87,7 @@ public:
 
 	handler_t *getHandle(iScheduler *inHandler)
 	{
-		index_t i;
+		index_type i;
 		if(getHandlerIndex(inHandler, i)){
 			return &mHandlerTraits[i];
 		}
@@ -66,7 +96,7 @@ public:
 
 	void removeHandler(iScheduler *inHandler)
 	{
-		index_t i;
+		index_type i;
 		if(getHandlerIndex(inHandler, i)){
 
 			if(!mHandlerTraits[i].isDelReady())
@@ -93,10 +123,12 @@ public:
 		
 		bool fullCycleExe = false;
 		tick_t startTick = SysKernelData::sGetTick();
+		tick_t cycleStart = startTick;
+		tick_t cycleEnd;
 		
 		do
 		{
-			index_t i = 0;
+			index_type i = 0;
 			SysKernelData::sCnt++;
 
 			bool singleCycleExe = false;
@@ -124,12 +156,114 @@ public:
 				// at least one execution occured
 				fullCycleExe = true;
 			}
+
+			cycleEnd = SysKernelData::sGetTick();
+			// the idle cycles are not traced, unless over the overload threshold
+			if(singleCycleExe || (mOverloadThreshold && cycleEnd - cycleStart > mOverloadThreshold))
+			{
+				UCOSM_TRACE(TraceEvent::eCycle, singleCycleExe, cycleEnd - cycleStart);
+			}
+			if(mStatsPeriod)
+			{
+				updateStats(cycleStart, cycleEnd, singleCycleExe);
+			}
+			if(mOverloadThreshold)
+			{
+				updateOverload(cycleEnd - cycleStart);
+			}
+			cycleStart = cycleEnd;
 			
-		}while( ( SysKernelData::sGetTick() - startTick ) < inMinDuration );
+		}while( ( cycleEnd - startTick ) < inMinDuration );
 
 		return fullCycleExe;
 	}
 
+	// enables the statistics, computed over inPeriod ticks, 0 : disabled.
+	// inReport is called at the end of each period
+	void setStatsPeriod(tick_t inPeriod, void (*inReport)(const KernelStats &) = nullptr)
+	{
+		mStatsPeriod = inPeriod;
+		mStatsReport = inReport;
+		mStatsStart = SysKernelData::sGetTick();
+		mStats = KernelStats();
+	}
+
+	// overload control : a cycle longer than inThreshold ticks enters the overload state,
+	// inRecoveryCycles consecutive cycles within the threshold leave it.
+	// The tasks are shed according to their Criticality meanwhile, inNotify is called on
+	// each change of state. 0 : disabled
+	void setOverloadControl(tick_t inThreshold, uint16_t inRecoveryCycles = 16, void (*inNotify)(bool) = nullptr)
+	{
+		mOverloadThreshold = inThreshold;
+		mRecoveryCycles = inRecoveryCycles;
+		mOverloadNotify = inNotify;
+		mUnderloadCycles = 0;
+		setOverloaded(false);
+	}
+
+	bool isOverloaded() const
+	{
+		return SysKernelData::sIsOverloaded;
+	}
+
+	// writes the state of the kernel, its handlers and their tasks in outBuffer,
+	// returns the size of the snapshot, 0 if outBuffer is too small. See snapshot.h
+	size_t takeSnapshot(uint8_t *outBuffer, size_t inSize)
+	{
+		SnapshotWriter writer(outBuffer, inSize);
+		writer.putHeader(SysKernelData::sGetTick(), SysKernelData::sCnt);
+		snapshot(writer);
+		return writer.getSize();
+	}
+
+	void snapshot(SnapshotWriter &ioWriter)
+	{
+		ioWriter.put8(SnapshotWriter::eKernel);
+		ioWriter.put8(sizeof(index_type));
+		ioWriter.putIndex(mHandlerCount, sizeof(index_type));
+		ioWriter.put32(mLastStats.cycles);
+		ioWriter.put32(mLastStats.idleCycles);
+		ioWriter.put32(mLastStats.busy);
+		ioWriter.put32(mLastStats.longestCycle);
+		ioWriter.put32(mLastStats.period);
+		for(index_type i=0 ; i<mHandlerCount ; i++)
+		{
+			mHandlerTraits[i].snapshot(ioWriter);
+			mHandlers[i]->snapshot(ioWriter);
+		}
+	}
+
+	// statistics of the last completed period
+	const KernelStats &getStats() const
+	{
+		return mLastStats;
+	}
+
+	// earliest wake up tick of the handlers,
+	// a handler module delays the wake up of the tasks of its handler
+	bool getWakeTick(tick_t inTick, tick_t &outWake)
+	{
+		// the shed tasks are restored by the next cycles
+		if(SysKernelData::sIsOverloaded)
+		{
+			outWake = inTick;
+			return true;
+		}
+
+		bool isTimed = false;
+		for(index_type i=0 ; i<mHandlerCount ; i++)
+		{
+			tick_t handlerWake, taskWake;
+			if(mHandlers[i] && mHandlerTraits[i].getWakeTick(inTick, handlerWake) && mHandlers[i]->getWakeTick(inTick, taskWake))
+			{
+				tick_t wake = getLatestTick(handlerWake, taskWake);
+				outWake = isTimed ? getEarliestTick(outWake, wake) : wake;
+				isTimed = true;
+			}
+		}
+		return isTimed;
+	}
+
 	void setIdleTask(void (*inIdleTask)())
  	{
 		mIdleTask = inIdleTask;
@@ -139,7 +273,7 @@ public:
 private:
 
 
-	bool getHandlerIndex(iScheduler *inScheduler, index_t& ioIndex)
+	bool getHandlerIndex(iScheduler *inScheduler, index_type& ioIndex)
  	{
 		if(!mHandlerCount)
 		{
@@ -155,14 +289,94 @@ private:
 		return false;
 	}
 
+	void updateStats(tick_t inCycleStart, tick_t inCycleEnd, bool inHasExe)
+	{
+		const tick_t duration = inCycleEnd - inCycleStart;
+
+		mStats.cycles++;
+		if(inHasExe)
+		{
+			mStats.busy += duration;
+		}else{
+			mStats.idleCycles++;
+		}
+		if(duration > mStats.longestCycle)
+		{
+			mStats.longestCycle = duration;
+		}
+
+		// end of the period
+		if((inCycleEnd - mStatsStart) >= mStatsPeriod)
+		{
+			mStats.period = inCycleEnd - mStatsStart;
+			mLastStats = mStats;
+			mStats = KernelStats();
+			mStatsStart = inCycleEnd;
+
+			if(mStatsReport)
+			{
+				mStatsReport(mLastStats);
+			}
+		}
+	}
+
+	void updateOverload(tick_t inDuration)
+	{
+		if(inDuration > mOverloadThreshold)
+		{
+			mUnderloadCycles = 0;
+			if(!SysKernelData::sIsOverloaded)
+			{
+				UCOSM_TRACE(TraceEvent::eOverload, true, inDuration);
+			}
+			setOverloaded(true);
+		}
+		else if(SysKernelData::sIsOverloaded && ++mUnderloadCycles >= mRecoveryCycles)
+		{
+			UCOSM_TRACE(TraceEvent::eOverload, false, inDuration);
+			setOverloaded(false);
+		}
+	}
+
+	void setOverloaded(bool inOverloaded)
+	{
+		if(SysKernelData::sIsOverloaded == inOverloaded)
+		{
+			return;
+		}
+		SysKernelData::sIsOverloaded = inOverloaded;
+		if(mOverloadNotify)
+		{
+			mOverloadNotify(inOverloaded);
+		}
+	}
+
 	iScheduler *mHandlers[max_handler_count];
 
 	handler_t mHandlerTraits[max_handler_count];
 	
-	index_t mHandlerCount;
+	index_type mHandlerCount;
 
 	void (*mIdleTask)();
 
+	KernelStats mStats;
+
+	KernelStats mLastStats;
+
+	tick_t mStatsPeriod;
+
+	tick_t mStatsStart;
+
+	void (*mStatsReport)(const KernelStats &);
+
+	tick_t mOverloadThreshold;
+
+	uint16_t mRecoveryCycles;
+
+	uint16_t mUnderloadCycles;
+
+	void (*mOverloadNotify)(bool);
+
 };
 
 
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2020 Thomas AUBERT <aubert.thms@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name ``Thomas AUBERT'' nor the name of any other
+ *    contributor may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 
+ * uCosmDev IS PROVIDED BY Thomas AUBERT ``AS IS'' AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL Thomas AUBERT OR ANY OTHER CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+
+
+
+
+// Flight recorder : the trace events (see trace.h) are written in a ring mapped on a file,
+// the page cache keeps the file content when the process crashes.
+// A record is a few plain stores in the mapping : no system call per event.
+// Must be included before the scheduler headers, it defines UCOSM_TRACE :
+//
+//	#include "/uCoSM/linux/flight-recorder.h"
+//	#include "/uCoSM/kernel.h"
+//
+//	ucosm_linux::FlightRecorder recorder;
+//	recorder.open("/var/tmp/ucosm.trace", 4096);
+//
+// tools/flight-dump.cc prints the last seconds of a recording.
+
+#ifndef UCOSM_TRACE
+#define UCOSM_TRACE(inEvent, inArg0, inArg1) \
+	ucosm_linux::FlightRecorder::record(inEvent, static_cast<uint32_t>(inArg0), static_cast<uint64_t>(inArg1))
+#endif
+
+#include "../uscosm-sys-data.h"
+
+
+
+
+namespace ucosm_linux
+{
+
+// layout of the ring file : header, then record_count records
+struct FlightRecord // 24 bytes
+{
+	uint32_t tick;
+	uint32_t cycle;
+	uint16_t event;
+	uint16_t reserved;
+	uint32_t arg0;
+	uint64_t arg1;		// 64 bits : holds the handler and pool addresses
+};
+
+struct FlightHeader // 24 bytes
+{
+	static const uint32_t magic_value = 0x5246434D; // "MCFR"
+	static const uint16_t version_value = 3;
+
+	uint32_t magic;
+	uint16_t version;
+	uint16_t recordSize;
+	uint32_t recordCount;
+	uint32_t ticksPerSecond;
+	uint64_t written;		// total count of records written, the next one goes to written%recordCount
+};
+
+
+
+class FlightRecorder
+{
+
+public:
+
+	FlightRecorder() : mFd(-1), mMap(nullptr), mSize(0)
+	{}
+
+	~FlightRecorder()
+	{
+		close();
+	}
+
+	// maps inPath on a ring of inRecordCount records, the recording of a previous run is
+	// continued when the file has the same layout. Records the events from then on.
+	bool open(const char *inPath, uint32_t inRecordCount, uint32_t inTicksPerSecond = 1000)
+	{
+		close();
+		if(!inRecordCount){ return false; }
+
+		mFd = ::open(inPath, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+		if(mFd < 0){ return false; }
+
+		mSize = sizeof(FlightHeader) + static_cast<size_t>(inRecordCount)*sizeof(FlightRecord);
+		if(ftruncate(mFd, mSize) != 0)
+		{
+			close();
+			return false;
+		}
+
+		void *map = mmap(nullptr, mSize, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+		if(map == MAP_FAILED)
+		{
+			close();
+			return false;
+		}
+		mMap = static_cast<uint8_t *>(map);
+
+		FlightHeader *header = getHeader();
+		if(header->magic != FlightHeader::magic_value || header->version != FlightHeader::version_value ||
+			header->recordSize != sizeof(FlightRecord) || header->recordCount != inRecordCount)
+		{
+			header->version = FlightHeader::version_value;
+			header->recordSize = sizeof(FlightRecord);
+			header->recordCount = inRecordCount;
+			header->written = 0;
+			header->magic = FlightHeader::magic_value;
+		}
+		header->ticksPerSecond = inTicksPerSecond;
+
+		sInstance = this;
+		return true;
+	}
+
+	// stops the recording, the file keeps the records
+	void close()
+	{
+		if(sInstance == this){ sInstance = nullptr; }
+		if(mMap)
+		{
+			munmap(mMap, mSize);
+			mMap = nullptr;
+		}
+		if(mFd >= 0)
+		{
+			::close(mFd);
+			mFd = -1;
+		}
+	}
+
+	// flushes the mapping to the storage : protects the records from a system crash,
+	// not needed for a process crash
+	void sync()
+	{
+		if(mMap){ msync(mMap, mSize, MS_ASYNC); }
+	}
+
+	// UCOSM_TRACE backend
+	static void record(uint16_t inEvent, uint32_t inArg0, uint64_t inArg1)
+	{
+		FlightRecorder *recorder = sInstance;
+		if(!recorder){ return; }
+
+		FlightHeader *header = recorder->getHeader();
+		const uint64_t written = header->written;
+		FlightRecord *r = recorder->getRecords() + (written % header->recordCount);
+		r->tick = SysKernelData::sGetTick();
+		r->cycle = SysKernelData::sCnt;
+		r->event = inEvent;
+		r->reserved = 0;
+		r->arg0 = inArg0;
+		r->arg1 = inArg1;
+
+		// the record is complete in the mapping before it is counted
+		std::atomic_signal_fence(std::memory_order_release);
+		header->written = written + 1;
+	}
+
+private:
+
+	FlightHeader *getHeader()
+	{
+		return reinterpret_cast<FlightHeader *>(mMap);
+	}
+
+	FlightRecord *getRecords()
+	{
+		return reinterpret_cast<FlightRecord *>(mMap + sizeof(FlightHeader));
+	}
+
+	static FlightRecorder *sInstance;
+
+	int mFd;
+
+	uint8_t *mMap;
+
+	size_t mSize;
+
+};
+
+FlightRecorder *FlightRecorder::sInstance = nullptr;
+
+}
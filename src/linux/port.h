@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2020 Thomas AUBERT <aubert.thms@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name ``Thomas AUBERT'' nor the name of any other
+ *    contributor may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 
+ * uCosmDev IS PROVIDED BY Thomas AUBERT ``AS IS'' AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL Thomas AUBERT OR ANY OTHER CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#pragma once
+
+#include <sys/epoll.h>
+#include <time.h>
+
+#include "../modules.h"
+
+
+
+
+// Linux userspace port :
+//  - SysKernelData::sGetTick is defined on CLOCK_MONOTONIC, 1 tick = 1 ms
+//  - IoWait : task module waiting for the readiness of a file descriptor
+//  - waitForEvents() blocks in epoll_wait until the next wake up tick of the
+//    scheduler or the readiness of a waited file descriptor, it replaces the
+//    spin of the main loop :
+//
+//		while(1)
+//		{
+//			kernel.schedule();
+//			ucosm_linux::waitForEvents(kernel);
+//		}
+
+namespace ucosm_linux
+{
+
+inline tick_t getMonotonicTick()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<tick_t>(static_cast<uint64_t>(ts.tv_sec)*1000 + ts.tv_nsec/1000000);
+}
+
+struct EventLoop
+{
+	// created on first use
+	static int getEpollFd()
+	{
+		if(sEpollFd < 0)
+		{
+			sEpollFd = epoll_create1(EPOLL_CLOEXEC);
+		}
+		return sEpollFd;
+	}
+
+private:
+
+	static int sEpollFd;
+};
+
+int EventLoop::sEpollFd = -1;
+
+} // end of ucosm_linux namespace
+
+
+
+tick_t (*SysKernelData::sGetTick)() = &ucosm_linux::getMonotonicTick;
+
+
+
+
+
+namespace ucosm_modules
+{
+
+// waits for the readiness of a file descriptor :
+// the task is not ready until epoll reports one of the waited events,
+// the events are consumed by the execution of the task.
+// The fd is level-triggered : unread data makes the task ready again.
+// Call clearWait() before closing the fd.
+struct IoWait // 8 bytes
+{
+
+	// inEvents : EPOLLIN, EPOLLOUT, ...
+	bool setWait(int inFd, uint32_t inEvents = EPOLLIN)
+	{
+		clearWait();
+
+		epoll_event ev;
+		ev.events = inEvents;
+		ev.data.ptr = this;
+		if(epoll_ctl(ucosm_linux::EventLoop::getEpollFd(), EPOLL_CTL_ADD, inFd, &ev) != 0)
+		{
+			return false;
+		}
+		mFd = inFd;
+		return true;
+	}
+
+	void clearWait()
+	{
+		if(mFd >= 0)
+		{
+			epoll_ctl(ucosm_linux::EventLoop::getEpollFd(), EPOLL_CTL_DEL, mFd, nullptr);
+			mFd = -1;
+		}
+		mEvents = 0;
+	}
+
+	int getFd() const { return mFd; }
+
+	// events reported by epoll, valid during the execution of the task
+	uint32_t getEvents() const { return mEvents; }
+
+	// called by waitForEvents()
+	void notify(uint32_t inEvents) { mEvents |= inEvents; }
+
+	static const uint8_t snapshot_id = SnapshotWriter::eIoWait;
+
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put32(static_cast<uint32_t>(mFd));
+		ioWriter.put32(mEvents);
+	}
+
+protected:
+
+	template<typename derived_t>
+	void init()
+	{
+		mFd = -1;
+		mEvents = 0;
+	}
+	
+	// a task without waited fd is always ready
+	bool isExeReady() const { return mFd < 0 || mEvents; }
+	bool isDelReady() const { return true; }
+	void makePreExe(){}
+	void makePreDel(){ clearWait(); }
+	void makePostExe(){ mEvents = 0; }
+
+private:
+
+	int mFd;
+	uint32_t mEvents;
+};
+
+} // end of ucosm_modules namespace
+
+
+
+
+
+namespace ucosm_linux
+{
+
+// blocks until the next wake up tick of inScheduler or the readiness of a waited fd,
+// returns immediately if a task is ready
+template<int max_events = 16>
+void waitForEvents(iScheduler &inScheduler)
+{
+	tick_t now = SysKernelData::sGetTick();
+	tick_t wake;
+	int timeout = -1;
+	if(inScheduler.getWakeTick(now, wake))
+	{
+		timeout = isTickReached(now, wake) ? 0 : static_cast<int>(wake - now);
+	}
+
+	epoll_event events[max_events];
+	int n = epoll_wait(EventLoop::getEpollFd(), events, max_events, timeout);
+	for(int k=0 ; k<n ; k++)
+	{
+		static_cast<ucosm_modules::IoWait *>(events[k].data.ptr)->notify(events[k].events);
+	}
+}
+
+} // end of ucosm_linux namespace
@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2020 Thomas AUBERT <aubert.thms@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name ``Thomas AUBERT'' nor the name of any other
+ *    contributor may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 
+ * uCosmDev IS PROVIDED BY Thomas AUBERT ``AS IS'' AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL Thomas AUBERT OR ANY OTHER CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+
+
+
+// Signal between two processes : single producer single consumer ring in a POSIX
+// shared memory segment.
+//  - lock-free, the head (sender) and the tail (receiver) are on separate cache lines
+//  - zero copy : the elements are written and read in place in the segment
+//  - the receiver polls it (isEmpty()) or waits on the eventfd of the channel with IoWait,
+//    the sender writes the eventfd only when the ring was empty : no system call per element
+//
+// The eventfd is shared by inheritance (fork) or passed with sendFd()/receiveFd() :
+//
+//	// sender process
+//	ShmChannel<Message, 64> channel;
+//	channel.create("/gateway-rx");
+//	ucosm_linux::sendFd(socket, channel.getNotifyFd());
+//	channel.send(message);
+//
+//	// receiver process
+//	channel.attach("/gateway-rx", ucosm_linux::receiveFd(socket));
+//	handle->setWait(channel.getNotifyFd());
+//
+//	void rxProcess()
+//	{
+//		Message m;
+//		while(channel.receive(m)){ ... }
+//	}
+
+namespace ucosm_linux
+{
+
+// elem_count : power of two
+template<typename T, uint32_t elem_count>
+class ShmChannel
+{
+
+	static_assert(std::is_trivially_copyable<T>::value, "ShmChannel element must be trivially copyable");
+	static_assert(elem_count && !(elem_count & (elem_count-1)), "ShmChannel size must be a power of two");
+	static_assert(ATOMIC_INT_LOCK_FREE == 2, "ShmChannel requires lock-free atomics");
+
+	static const uint32_t cache_line = 64;
+
+	// layout of the segment
+	struct Ring
+	{
+		static const uint32_t magic_value = 0x4843534D; // "MSCH"
+
+		uint32_t magic;
+		uint32_t elemSize;
+		uint32_t elemCount;
+
+		alignas(cache_line) std::atomic<uint32_t> head;	// written by the sender
+		alignas(cache_line) std::atomic<uint32_t> tail;	// written by the receiver
+		alignas(cache_line) T elems[elem_count];
+	};
+
+public:
+
+	ShmChannel() : mRing(nullptr), mNotifyFd(-1)
+	{}
+
+	~ShmChannel()
+	{
+		close();
+	}
+
+	// creates the segment and the eventfd, the receiver attaches to it
+	bool create(const char *inName)
+	{
+		close();
+		int fd = shm_open(inName, O_RDWR | O_CREAT | O_TRUNC, 0600);
+		if(fd < 0){ return false; }
+		if(ftruncate(fd, sizeof(Ring)) != 0 || !map(fd))
+		{
+			::close(fd);
+			return false;
+		}
+		::close(fd);
+
+		mRing->elemSize = sizeof(T);
+		mRing->elemCount = elem_count;
+		mRing->head.store(0, std::memory_order_relaxed);
+		mRing->tail.store(0, std::memory_order_relaxed);
+		mRing->magic = Ring::magic_value;
+
+		mNotifyFd = eventfd(0, EFD_NONBLOCK);
+		if(mNotifyFd < 0)
+		{
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	// attaches to a segment created by the other process,
+	// inNotifyFd : eventfd of the channel, -1 for a polled channel
+	bool attach(const char *inName, int inNotifyFd = -1)
+	{
+		close();
+		int fd = shm_open(inName, O_RDWR, 0600);
+		if(fd < 0){ return false; }
+		struct stat st;
+		if(fstat(fd, &st) != 0 || st.st_size != static_cast<off_t>(sizeof(Ring)) || !map(fd))
+		{
+			::close(fd);
+			return false;
+		}
+		::close(fd);
+
+		if(mRing->magic != Ring::magic_value || mRing->elemSize != sizeof(T) || mRing->elemCount != elem_count)
+		{
+			close();
+			return false;
+		}
+		mNotifyFd = inNotifyFd;
+		return true;
+	}
+
+	// removes the segment name, the mapped channels remain valid
+	static void unlink(const char *inName)
+	{
+		shm_unlink(inName);
+	}
+
+	void close()
+	{
+		if(mRing)
+		{
+			munmap(mRing, sizeof(Ring));
+			mRing = nullptr;
+		}
+		if(mNotifyFd >= 0)
+		{
+			::close(mNotifyFd);
+			mNotifyFd = -1;
+		}
+	}
+
+	int getNotifyFd() const { return mNotifyFd; }
+
+	// sender side
+
+	// slot of the next element, nullptr if the ring is full
+	T *getWriteSlot()
+	{
+		const uint32_t head = mRing->head.load(std::memory_order_relaxed);
+		if(head - mRing->tail.load(std::memory_order_acquire) == elem_count)
+		{
+			return nullptr;
+		}
+		return &mRing->elems[head & (elem_count-1)];
+	}
+
+	// publishes the element written in the write slot
+	void commitWrite()
+	{
+		const uint32_t head = mRing->head.load(std::memory_order_relaxed);
+		mRing->head.store(head+1, std::memory_order_release);
+
+		// the receiver empties the ring then clears the eventfd :
+		// it is written when the receiver may have seen the ring empty
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(mNotifyFd >= 0 && mRing->tail.load(std::memory_order_relaxed) == head)
+		{
+			const uint64_t one = 1;
+			static_cast<void>(write(mNotifyFd, &one, sizeof(one)));
+		}
+	}
+
+	bool send(const T &inData)
+	{
+		T *slot = getWriteSlot();
+		if(!slot){ return false; }
+		*slot = inData;
+		commitWrite();
+		return true;
+	}
+
+	// receiver side
+
+	bool isEmpty() const
+	{
+		return mRing->tail.load(std::memory_order_relaxed) == mRing->head.load(std::memory_order_acquire);
+	}
+
+	uint32_t getCount() const
+	{
+		return mRing->head.load(std::memory_order_acquire) - mRing->tail.load(std::memory_order_relaxed);
+	}
+
+	// oldest element, nullptr if the ring is empty : the eventfd is then cleared
+	const T *getReadSlot()
+	{
+		if(isEmpty())
+		{
+			clearNotify();
+			if(isEmpty()){ return nullptr; }
+		}
+		return &mRing->elems[mRing->tail.load(std::memory_order_relaxed) & (elem_count-1)];
+	}
+
+	// releases the element of the read slot
+	void commitRead()
+	{
+		const uint32_t tail = mRing->tail.load(std::memory_order_relaxed);
+		mRing->tail.store(tail+1, std::memory_order_release);
+	}
+
+	bool receive(T &outData)
+	{
+		const T *slot = getReadSlot();
+		if(!slot){ return false; }
+		outData = *slot;
+		commitRead();
+		return true;
+	}
+
+private:
+
+	bool map(int inFd)
+	{
+		void *map = mmap(nullptr, sizeof(Ring), PROT_READ | PROT_WRITE, MAP_SHARED, inFd, 0);
+		if(map == MAP_FAILED){ return false; }
+		mRing = static_cast<Ring *>(map);
+		return true;
+	}
+
+	void clearNotify()
+	{
+		if(mNotifyFd < 0){ return; }
+		uint64_t count;
+		static_cast<void>(read(mNotifyFd, &count, sizeof(count)));
+
+		// pairs with the fence of commitWrite() : an element sent meanwhile is seen by the
+		// recheck of the caller or notified again
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+
+	Ring *mRing;
+
+	int mNotifyFd;
+
+};
+
+
+
+// passes a file descriptor to another process over a unix domain socket
+inline bool sendFd(int inSocket, int inFd)
+{
+	char data = 0;
+	iovec iov = {&data, sizeof(data)};
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+	msghdr msg = {};
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &inFd, sizeof(int));
+
+	return sendmsg(inSocket, &msg, 0) == sizeof(data);
+}
+
+// file descriptor sent by sendFd(), -1 on failure
+inline int receiveFd(int inSocket)
+{
+	char data;
+	iovec iov = {&data, sizeof(data)};
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+
+	msghdr msg = {};
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	if(recvmsg(inSocket, &msg, MSG_CMSG_CLOEXEC) != sizeof(data)){ return -1; }
+
+	cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	if(!cmsg || cmsg->cmsg_type != SCM_RIGHTS){ return -1; }
+
+	int fd;
+	memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+	return fd;
+}
+
+}
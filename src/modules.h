@@ -29,6 +29,9 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstring>
+#include <new>
 #include <type_traits>
 #include "uscosm-sys-data.h"
 #include "utils.h"
@@ -43,6 +46,8 @@
  *  must contain a set of funtions :
  * 
  *	  - template<typename derived_t> void init()
+ *	    may also take the extra arguments of createTask() (see Content) :
+ *	    template<typename derived_t, typename ...Args> void init(Args&&...)
  * 
  *	  - bool isExeReady const ()
  *	  - bool isDelReady const ()
@@ -51,32 +56,268 @@
  *	  - void makePreDel()
  *	  - void makePostExe()
  *	  	  
+ *  may be bound to the task containing it :
+ *
+ *	  - template<typename derived_t, uint8_t flag_offset> using bind = ...
+ *	  - static const uint8_t flag_bits
+ *
+ *	  Modules<> then inherits bind<Modules<...>, flag_offset> instead of the module,
+ *	  the bound module reaches its sibling modules through derived_t and stores its
+ *	  flag_bits in the flag word shared by the modules of the task (see FlagField).
+ *	  Without a task (SoaModules), the module is bind<void, 0>.
+ *
+ *  may tell when a task that is not ready can become ready (see getWakeTick) :
+ *
+ *	  - static const bool has_deadline, with const tick_t *getDeadline() const
+ *	  - static const bool is_polled, the readiness depends on the kernel cycles
+ *
+ *	  otherwise a module that is not ready waits for an event.
+ *
+ *  may order the dispatch of the ready tasks of its handler (see AgingPrio) :
+ *
+ *	  - static const bool has_priority, with uint32_t getDispatchRank() const,
+ *	    the lowest rank is dispatched first, and void makeWait() called for
+ *	    each ready task left undispatched when the handler budget is consumed
+ *
+ *  may be constant-initialized (see StaticTaskHandler) :
+ *
+ *	  - default member initializers giving the init() state at cycle 0 and tick 0,
+ *	    its flag bits start at 0
  * 
  */
 
 
 
 
+// flag word shared by the modules of a task
+template<typename word_t>
+struct FlagWord
+{
+protected:
+
+	template<typename derived_t, uint8_t flag_offset, uint8_t flag_bits>
+	friend struct FlagField;
+
+	word_t mFlags = 0;
+};
+
+template<>
+struct FlagWord<void>
+{};
+
+
+
+// smallest type holding flag_count bits
+template<uint8_t flag_count>
+struct FlagWordType
+{
+	static_assert(flag_count <= 32, "Modules claim more than 32 flag bits");
+
+	using type = typename std::conditional<(flag_count > 16), uint32_t,
+		typename std::conditional<(flag_count > 8), uint16_t,
+		typename std::conditional<(flag_count > 0), uint8_t, void>::type>::type>::type;
+};
+
+
+
+// field of flag_bits bits, packed at flag_offset in the flag word of derived_t
+template<typename derived_t, uint8_t flag_offset, uint8_t flag_bits>
+struct FlagField
+{
+	static_assert(flag_bits <= 8, "Flag field exceeds 8 bits");
+
+	uint8_t getField() const
+	{
+		return (getWord<derived_t>() >> flag_offset) & field_mask;
+	}
+
+	void setField(uint8_t inValue)
+	{
+		setWord<derived_t>(inValue);
+	}
+
+private:
+
+	static const uint8_t field_mask = (1<<flag_bits)-1;
+
+	// derived_t is incomplete when the field is declared : the flag word type is resolved on use
+	template<typename D>
+	const typename D::flag_word_t &getWord() const
+	{
+		return static_cast<const FlagWord<typename D::flag_word_t> &>(*static_cast<const D *>(this)).mFlags;
+	}
+
+	template<typename D>
+	void setWord(uint8_t inValue)
+	{
+		using word_t = typename D::flag_word_t;
+		word_t &w = static_cast<FlagWord<word_t> &>(*static_cast<D *>(this)).mFlags;
+		w = (w & ~(static_cast<word_t>(field_mask) << flag_offset)) | 
+			(static_cast<word_t>(inValue & field_mask) << flag_offset);
+	}
+};
+
+// field stored by the module itself, when the module is not bound to a task
+template<uint8_t flag_offset, uint8_t flag_bits>
+struct FlagField<void, flag_offset, flag_bits>
+{
+	static_assert(flag_bits <= 8, "Flag field exceeds 8 bits");
+
+	uint8_t getField() const { return mField; }
+	void setField(uint8_t inValue) { mField = inValue; }
+
+private:
+
+	uint8_t mField;
+};
+
+
+
+// module as inherited by Modules<>
+template<typename module_t, typename derived_t, uint8_t flag_offset, typename = void>
+struct BindModule
+{
+	using type = module_t;
+	static const uint8_t flag_bits = 0;
+};
+
+template<typename module_t, typename derived_t, uint8_t flag_offset>
+struct BindModule<module_t, derived_t, flag_offset, VoidT<typename module_t::template bind<void, 0>>>
+{
+	using type = typename module_t::template bind<derived_t, flag_offset>;
+	static const uint8_t flag_bits = module_t::flag_bits;
+};
+
+template<typename module_t>
+using FlagBits = BindModule<module_t, void, 0>;
+
+
+
+// true if the module readiness only depends on a deadline, i.e. it defines has_deadline
+template<typename module_t, typename = void>
+struct HasDeadline : std::false_type
+{};
+
+template<typename module_t>
+struct HasDeadline<module_t, typename std::enable_if<module_t::has_deadline>::type> : std::true_type
+{};
+
+// true if the module readiness depends on the kernel cycles, i.e. it defines is_polled
+template<typename module_t, typename = void>
+struct IsPolled : std::false_type
+{};
+
+template<typename module_t>
+struct IsPolled<module_t, typename std::enable_if<module_t::is_polled>::type> : std::true_type
+{};
+
+// true if the module orders the dispatch of the ready tasks, i.e. it defines has_priority
+template<typename module_t, typename = void>
+struct HasPriority : std::false_type
+{};
+
+template<typename module_t>
+struct HasPriority<module_t, typename std::enable_if<module_t::has_priority>::type> : std::true_type
+{};
+
+
+
+// true if the module writes its own state in a snapshot, i.e. it defines snapshot_id
+template<typename module_t, typename = void>
+struct HasSnapshot : std::false_type
+{};
+
+template<typename module_t>
+struct HasSnapshot<module_t, VoidT<decltype(module_t::snapshot_id)>> : std::true_type
+{};
+
+// writes the record of a module in a snapshot : id, length, state
+template<typename module_t>
+typename std::enable_if<HasSnapshot<module_t>::value>::type snapshotModule(const module_t &inModule, SnapshotWriter &ioWriter)
+{
+	ioWriter.put8(module_t::snapshot_id);
+	const size_t lengthPosition = ioWriter.getPosition();
+	ioWriter.put16(0);
+	inModule.snapshot(ioWriter);
+	ioWriter.patch16(lengthPosition, static_cast<uint16_t>(ioWriter.getPosition() - lengthPosition - 2));
+}
+
+template<typename module_t>
+typename std::enable_if<!HasSnapshot<module_t>::value>::type snapshotModule(const module_t &inModule, SnapshotWriter &ioWriter)
+{
+	const size_t size = std::is_empty<module_t>::value ? 0 : sizeof(module_t);
+	const uint16_t length = (size < 0xFFFF) ? size : 0xFFFF;
+	ioWriter.put8(SnapshotWriter::eRaw);
+	ioWriter.put16(length);
+	ioWriter.putBytes(&inModule, length);
+}
+
+
+
+// offset of the flag bits of module_t
+template<typename module_t, class ...ModuleCollection>
+struct FlagOffset;
+
+template<typename module_t, typename first_t, class ...ModuleCollection>
+struct FlagOffset<module_t, first_t, ModuleCollection...>
+{
+	static const uint8_t value = std::is_same<module_t, first_t>::value ? 0 : 
+		FlagBits<first_t>::flag_bits + FlagOffset<module_t, ModuleCollection...>::value;
+};
+
+template<typename module_t>
+struct FlagOffset<module_t>
+{
+	static const uint8_t value = 0;
+};
+
+
+
+
 
 
 
 template<class ...ModuleCollection> 
-struct Modules : public ModuleCollection...
+struct Modules : public FlagWord<typename FlagWordType<FlagOffset<void, ModuleCollection...>::value>::type>,
+	public BindModule<ModuleCollection, Modules<ModuleCollection...>, FlagOffset<ModuleCollection, ModuleCollection...>::value>::type...
 {
 
-	Modules()
-	{}
+	// bits used in the flag word
+	static const uint8_t flag_count = FlagOffset<void, ModuleCollection...>::value;
 
-	void init()
+	using flag_word_t = typename FlagWordType<flag_count>::type;
+
+	template<typename module_t>
+	using bound_t = typename BindModule<module_t, Modules<ModuleCollection...>, 
+		FlagOffset<module_t, ModuleCollection...>::value>::type;
+
+	template<typename module_t>
+	static constexpr bool hasModule()
 	{
-		uint8_t d[] = {(uint8_t)0, (ModuleCollection::template init<Modules<ModuleCollection...>>(), (uint8_t)0)...};
-		static_cast<void>(d); // avoid warning for unused variable
+		return anyOf({false, std::is_same<module_t, ModuleCollection>::value...});
+	}
+
+	// bytes used by module_t in the task, its flag bits excepted
+	template<typename module_t>
+	static constexpr std::size_t getModuleSize()
+	{
+		return std::is_empty<bound_t<module_t>>::value ? 0 : sizeof(bound_t<module_t>);
+	}
+
+	Modules() = default;
+
+	// the arguments are given to the first module whose init takes them, the others are
+	// initialized without argument. Arguments taken by no module don't compile
+	template<typename ...Args>
+	void init(Args&&... inArgs)
+	{
+		initModules(std::index_sequence_for<ModuleCollection...>(), std::forward<Args>(inArgs)...);
 	}
 
 	bool isExeReady()
 	{
 		bool ready[] = {
-			true, (ModuleCollection::isExeReady())...
+			true, (bound_t<ModuleCollection>::isExeReady())...
 		};
 		for(index_t i=0 ; i<sizeof(ready) ; i++)
 		{
@@ -88,7 +329,7 @@ struct Modules : public ModuleCollection...
 	bool isDelReady()
 	{
 		bool ready[] = {
-			true, (ModuleCollection::isDelReady())...
+			true, (bound_t<ModuleCollection>::isDelReady())...
 		};
 		for(index_t i=0 ; i<sizeof(ready) ; i++)
 		{
@@ -97,31 +338,162 @@ struct Modules : public ModuleCollection...
 		return true;
 	}
 
+	// the tasks are dispatched by rank when a module orders the dispatch
+	static const bool has_priority = anyOf({false, HasPriority<ModuleCollection>::value...});
+
+	uint32_t getDispatchRank() const
+	{
+		uint32_t rank = ~static_cast<uint32_t>(0);
+		const uint32_t ranks[] = {rank, getModuleRank<ModuleCollection>()...};
+		for(const uint32_t r : ranks)
+		{
+			if(r < rank){ rank = r; }
+		}
+		return rank;
+	}
+
+	void makeWait()
+	{
+		uint8_t d[] = {(uint8_t)0, (makeModuleWait<ModuleCollection>(), (uint8_t)0)...};
+		static_cast<void>(d); // avoid warning for unused variable
+	}
+
 	void makePreExe()
 	{
-		uint8_t d[] = {(uint8_t)0, (ModuleCollection::makePreExe(), (uint8_t)0)...};
+		uint8_t d[] = {(uint8_t)0, (bound_t<ModuleCollection>::makePreExe(), (uint8_t)0)...};
 		static_cast<void>(d); // avoid warning for unused variable
 	}
 
 	void makePostExe()
 	{
-		uint8_t d[] = {(uint8_t)0, (ModuleCollection::makePostExe(), (uint8_t)0)...};
+		uint8_t d[] = {(uint8_t)0, (bound_t<ModuleCollection>::makePostExe(), (uint8_t)0)...};
 		static_cast<void>(d); // avoid warning for unused variable
 	}
 	 
 	void makePreDel()
 	{
 		uint8_t d[] = {
-			(uint8_t)0, (ModuleCollection::makePreDel(), (uint8_t)0)...
+			(uint8_t)0, (bound_t<ModuleCollection>::makePreDel(), (uint8_t)0)...
 		};
 		static_cast<void>(d); // avoid warning for unused variable
 	}
+
+	// writes the state of the modules, see snapshot.h
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put8(sizeof...(ModuleCollection));
+		uint8_t d[] = {(uint8_t)0, (snapshotModule<bound_t<ModuleCollection>>(*this, ioWriter), (uint8_t)0)...};
+		static_cast<void>(d); // avoid warning for unused variable
+	}
+
+	// earliest tick at which the task may be ready, evaluated at inTick,
+	// returns false when only an event can make the task ready
+	bool getWakeTick(tick_t inTick, tick_t &outWake)
+	{
+		outWake = inTick;
+		bool timed[] = {
+			true, (getModuleWakeTick<ModuleCollection>(outWake))...
+		};
+		for(index_t i=0 ; i<sizeof(timed) ; i++)
+		{
+			if(!timed[i]){ return false; }
+		}
+		return true;
+	}
 	
 private:
+
+	template<std::size_t ...I, typename ...Args>
+	void initModules(std::index_sequence<I...>, Args&&... inArgs)
+	{
+		static const std::size_t target = firstOf({decltype(takesInit<bound_t<ModuleCollection>, Modules, Args...>(0))::value...});
+		static_assert(sizeof...(Args) == 0 || target < sizeof...(ModuleCollection), "No module init takes these createTask arguments");
+
+		uint8_t d[] = {(uint8_t)0, (initModule<bound_t<ModuleCollection>>(*this, std::integral_constant<bool, I == target>(), std::forward<Args>(inArgs)...), (uint8_t)0)...};
+		static_cast<void>(d); // avoid warning for unused variable
+	}
+
+	// true if the init of base_t takes the arguments
+	template<typename base_t, typename self_t, typename ...Args>
+	static auto takesInit(int)
+		-> decltype(std::declval<self_t &>().base_t::template init<self_t>(std::declval<Args>()...), std::true_type());
+
+	template<typename base_t, typename self_t, typename ...Args>
+	static std::false_type takesInit(long);
+
+	// the init of the module taking the arguments, the init without argument for the others
+	template<typename base_t, typename self_t, typename ...Args>
+	static void initModule(self_t &ioSelf, std::true_type, Args&&... inArgs)
+	{
+		ioSelf.base_t::template init<self_t>(std::forward<Args>(inArgs)...);
+	}
+
+	template<typename base_t, typename self_t, typename ...Args>
+	static void initModule(self_t &ioSelf, std::false_type, Args&&...)
+	{
+		ioSelf.base_t::template init<self_t>();
+	}
+
+	template<typename module_t>
+	typename std::enable_if<HasPriority<module_t>::value, uint32_t>::type getModuleRank() const
+	{
+		return bound_t<module_t>::getDispatchRank();
+	}
+
+	template<typename module_t>
+	typename std::enable_if<!HasPriority<module_t>::value, uint32_t>::type getModuleRank() const
+	{
+		return ~static_cast<uint32_t>(0);
+	}
+
+	template<typename module_t>
+	typename std::enable_if<HasPriority<module_t>::value>::type makeModuleWait()
+	{
+		bound_t<module_t>::makeWait();
+	}
+
+	template<typename module_t>
+	typename std::enable_if<!HasPriority<module_t>::value>::type makeModuleWait() {}
+
+	// a deadline module delays the wake up to its deadline
+	template<typename module_t>
+	typename std::enable_if<HasDeadline<module_t>::value, bool>::type getModuleWakeTick(tick_t &ioWake)
+	{
+		if(!bound_t<module_t>::isExeReady())
+		{
+			ioWake = getLatestTick(ioWake, *bound_t<module_t>::getDeadline());
+		}
+		return true;
+	}
+
+	// a polled module (Prio) keeps the task polled, the others wait for an event
+	template<typename module_t>
+	typename std::enable_if<!HasDeadline<module_t>::value, bool>::type getModuleWakeTick(tick_t &)
+	{
+		return IsPolled<module_t>::value || bound_t<module_t>::isExeReady();
+	}
 	
 };
 
 
+
+// on failure, the compiler reports FootprintCheck<footprint, budget>
+template<std::size_t footprint, std::size_t budget>
+struct FootprintCheck
+{
+	static_assert(footprint <= budget, "Task modules exceed their RAM budget");
+	static const bool value = true;
+};
+
+// compile time RAM budget of a task :
+// static_assert(FootprintBudget<Modules<...>, 8>::value, "");
+// the footprint of each module is given by Modules<...>::getModuleSize<module_t>()
+// and the flag bits used by Modules<...>::flag_count
+template<typename modules_t, std::size_t budget>
+struct FootprintBudget : public FootprintCheck<sizeof(modules_t), budget>
+{};
+
+
 using no_module = Modules<>;
 
 
@@ -142,43 +514,84 @@ namespace ucosm_modules
 // Allows to add basic task priority management :
 // the priority goes from 1 to 255
 // where 1 is the highest priority i.e. it will be executed on every mainloop cycles
-// and 255 is the lowest, it will be executed once every 255 mainloop cycles
-
-struct Prio // 1 byte
+// and 255 is the lowest, it will be executed once every 255 mainloop cycles.
+// The task keeps the cycle of its next execution : no division in the hot path.
+// A task which can't be executed when its cycle is reached is executed as soon as possible,
+// its handler must be scheduled at least once every 2^31 cycles.
+// With the catch-up option, the execution following a late one stays on the original grid :
+// it comes sooner, at the next cycle at most, so a task delayed once (handler budget consumed,
+// task suspended...) keeps its rate. A lateness over one interval is not made up.
+
+struct Prio // 8 bytes
 {
 
+	// the readiness depends on the kernel cycles
+	static const bool is_polled = true;
+
 	void setPriority(const uint8_t inPrio)
 	{
 		// priority can't be inferior to 1
 		mPriority = (inPrio)?inPrio:1; 
 	}
 
+	uint8_t getPriority() const
+	{
+		return mPriority;
+	}
+
+	void setCatchUp(const bool inCatchUp)
+	{
+		mCatchUp = inCatchUp;
+	}
+
+	static const uint8_t snapshot_id = SnapshotWriter::ePrio;
+
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put8(mPriority);
+		ioWriter.put8(mCatchUp);
+		ioWriter.put32(mNextCycle);
+	}
+
 protected:
 
 	template<typename derived_t>
 	 void init()
 	{
 		mPriority = 1;
+		mCatchUp = false;
+		mNextCycle = SysKernelData::sCnt;
 	}
 	 
     bool isExeReady() const 
 	{   
-		if(SysKernelData::sCnt)
-		{
-			return (!(SysKernelData::sCnt%mPriority));
-		}else{
-			return (!((SysKernelData::sCnt+1)%mPriority));
-		}
+		return static_cast<int32_t>(SysKernelData::sCnt - mNextCycle) >= 0;
 	}
 	 
 	bool isDelReady() const {return true;}
-	void makePreExe(){}
+	void makePreExe()
+	{
+		const cycle_t cycle = SysKernelData::sCnt;
+		if(mCatchUp)
+		{
+			mNextCycle += mPriority;
+			if(static_cast<int32_t>(cycle - mNextCycle) >= 0)
+			{
+				mNextCycle = cycle + 1;
+			}
+			return;
+		}
+		// a late task restarts its interval from the current cycle
+		mNextCycle = cycle + mPriority;
+	}
 	void makePreDel(){}
 	void makePostExe(){}
 	
 private:
 	 
-    uint8_t mPriority;
+    uint8_t mPriority = 1;
+	bool mCatchUp = false;
+	cycle_t mNextCycle = 0;
 };
 
 
@@ -188,13 +601,85 @@ private:
 
 
 
+// Prio whose tasks are dispatched by priority within a cycle, the highest first.
+// A due task left undispatched when the handler budget is consumed is blocked by the
+// higher priorities : it ages by one for each such cycle, and every age_step cycles of age
+// raise its effective priority by one. At the highest priority, the oldest task goes first :
+// a task waits (priority-1)*age_step+1 cycles at most. The age is reset by the execution.
+// Without Budget every due task is dispatched and the tasks don't age.
+template<uint8_t age_step = 1>
+struct AgingPrio : public Prio // 12 bytes
+{
+
+	static_assert(age_step > 0, "Age step can't be 0");
+
+	static const bool has_priority = true;
+
+	// cycles spent due but blocked since the last execution, saturates at 65535
+	uint16_t getAge() const
+	{
+		return mAge;
+	}
+
+	uint8_t getEffectivePriority() const
+	{
+		const uint16_t raise = mAge / age_step;
+		return (raise < getPriority()) ? getPriority() - raise : 1;
+	}
+
+	static const uint8_t snapshot_id = SnapshotWriter::eAgingPrio;
+
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		Prio::snapshot(ioWriter);
+		ioWriter.put16(mAge);
+	}
+
+protected:
+
+	template<typename derived_t>
+	void init()
+	{
+		Prio::init<derived_t>();
+		mAge = 0;
+	}
+
+	// effective priority, then the oldest first
+	uint32_t getDispatchRank() const
+	{
+		return (static_cast<uint32_t>(getEffectivePriority()) << 16) | static_cast<uint16_t>(~mAge);
+	}
+
+	void makeWait()
+	{
+		if(mAge < 0xFFFF){ mAge++; }
+	}
+
+	void makePreExe()
+	{
+		Prio::makePreExe();
+		mAge = 0;
+	}
+
+private:
+
+	uint16_t mAge = 0;
+};
+
+
+
+
+
+
 
 
 
 
-struct Status // 1 byte
+
+// status values shared by Status and StatusNotify
+struct StatusFlags
 {
- 
+
 	enum eStatus:uint8_t
 	{
 		eSuspended			= 0b00000100,
@@ -202,15 +687,30 @@ struct Status // 1 byte
 		eStatusMask			= 0b00001111
 	};
 
+protected:
+
+	enum eSystemStatus:uint8_t
+	{
+		eRunning			= 0b00000001,
+		eStarted			= 0b00000010
+	};
+
+};
+
+
+
+template<typename derived_t, uint8_t flag_offset>
+struct StatusModule : public StatusFlags, public FlagField<derived_t, flag_offset, 4>
+{
 		
-	bool isStatus(uint8_t s){ return ((mStatus&s) == s);}
+	bool isStatus(uint8_t s){ return ((getStatus()&s) == s);}
 		
 	void setStatus(uint8_t s, bool state)
 	{
 		// task is locked : cancel operation
 		if(isStatus(eLocked) && s!=eLocked){ return;}
 		
-		state ? mStatus|=s : mStatus&=~s;
+		this->setField(state ? getStatus()|s : getStatus()&~s);
 	}
 
 	void setStatus(eStatus s, bool state)
@@ -220,36 +720,46 @@ struct Status // 1 byte
 
 	bool isRunning()
 	{
-		return (mStatus&eRunning);
+		return (getStatus()&eRunning);
 	}
 
 	bool isStarted()
 	{
-		return (mStatus&eStarted);
+		return (getStatus()&eStarted);
+	}
+
+	static const uint8_t snapshot_id = SnapshotWriter::eStatus;
+
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put8(getStatus());
 	}
 
 protected:
 	
-	template<typename derived_t>
-	void init()	{ mStatus = 0; }
-	bool isExeReady() const { return !(mStatus&eSuspended) ;}
-	bool isDelReady() const { return !(mStatus&eLocked);}
-	void makePreExe(){  mStatus |= eRunning; }
+	template<typename>
+	void init()	{ this->setField(0); }
+	bool isExeReady() const { return !(getStatus()&eSuspended) ;}
+	bool isDelReady() const { return !(getStatus()&eLocked);}
+	void makePreExe(){ this->setField(getStatus()|eRunning); }
 	void makePreDel(){}
 	void makePostExe()
 	{
-		mStatus &= ~eRunning; 
-		mStatus |= eStarted;
+		this->setField((getStatus()&~eRunning)|eStarted);
 	}
+
+	uint8_t getStatus() const { return this->getField(); }
 	
-	enum eSystemStatus:uint8_t
-	{
-		eRunning			= 0b00000001,
-		eStarted			= 0b00000010
-	};
-	
-	uint8_t mStatus;
-	
+};
+
+
+
+struct Status : public StatusFlags // 4 flag bits
+{
+	static const uint8_t flag_bits = 4;
+
+	template<typename derived_t, uint8_t flag_offset>
+	using bind = StatusModule<derived_t, flag_offset>;
 };
 
 
@@ -257,31 +767,38 @@ protected:
 
 
 
-template<typename Callee_t>
-struct StatusNotify : private Status // 1 byte
+struct StatusNotifyFlags : public StatusFlags
 {
  
 	enum eNotifyStatus
 	{
-		eNotifyStarted		= Status::eStarted	<<3,	// 0b00010000
-		eNotifySuspended	= Status::eSuspended<<3,	// 0b00100000
-		eNotifyLocked		= Status::eLocked	<<3,	// 0b01000000
-		eNotifyDeleted		= 0b10000000,				// 0b10000000
-		eNotifyMask			= ~Status::eStatusMask
+		eNotifyStarted		= StatusFlags::eStarted	<<3,	// 0b00010000
+		eNotifySuspended	= StatusFlags::eSuspended<<3,	// 0b00100000
+		eNotifyLocked		= StatusFlags::eLocked	<<3,	// 0b01000000
+		eNotifyDeleted		= 0b10000000,					// 0b10000000
+		eNotifyMask			= ~StatusFlags::eStatusMask
     };
-	
-	bool isStatus(uint8_t s){ return ((mStatus&s) == s); }
-		
+
+};
+
+
+
+template<typename Callee_t, typename derived_t, uint8_t flag_offset>
+struct StatusNotifyModule : public StatusNotifyFlags, public FlagField<derived_t, flag_offset, 8>
+{
+	
+	bool isStatus(uint8_t s){ return ((getStatus()&s) == s); }
+		
 	void setStatus(uint8_t s, bool state)
 	{
-		if(isStatus(Status::eLocked) && s!=Status::eLocked){ return;}
+		if(isStatus(eLocked) && s!=eLocked){ return;}
 
-		uint8_t prevNotifStatus = (mStatus&Status::eStatusMask)<<3;
+		uint8_t prevNotifStatus = (getStatus()&eStatusMask)<<3;
 		
-		state ? mStatus|=s : mStatus&=~s;
+		this->setField(state ? getStatus()|s : getStatus()&~s);
 
 		// is the new status notifiable
-		uint8_t newNotifStatus = ((s&Status::eStatusMask)<<3)&(mStatus&eNotifyMask);
+		uint8_t newNotifStatus = ((s&eStatusMask)<<3)&(getStatus()&eNotifyMask);
 		
 		if(newNotifStatus)// status notifiable: notify callee
 		{
@@ -289,44 +806,230 @@ struct StatusNotify : private Status // 1 byte
 		}
 	}
 	
-	void setStatus(Status::eStatus s, bool state)
+	void setStatus(eStatus s, bool state)
 	{
 		setStatus(static_cast<uint8_t>(s), state);
 	}
+
+	bool isRunning()
+	{
+		return (getStatus()&eRunning);
+	}
+
+	bool isStarted()
+	{
+		return (getStatus()&eStarted);
+	}
 	
 
+	static const uint8_t snapshot_id = SnapshotWriter::eStatusNotify;
+
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put8(this->getField());
+	}
+
 protected:
 
-	template<typename derived_t>
-	void init()	{ mStatus = 0; }
+	template<typename>
+	void init()	{ this->setField(0); }
 	
-	bool isExeReady() const { return !(mStatus&Status::eSuspended) ;}
-	bool isDelReady() const { return !(mStatus&Status::eLocked);}
+	bool isExeReady() const { return !(getStatus()&eSuspended) ;}
+	bool isDelReady() const { return !(getStatus()&eLocked);}
 
 	void makePreExe()
 	{  
-		setStatus(Status::eRunning, true); 
+		setStatus(eRunning, true); 
 	}
 	
 	void makePostExe()
 	{
-		setStatus(Status::eRunning, false); 
-		setStatus(Status::eStarted, true);
+		setStatus(eRunning, false); 
+		setStatus(eStarted, true);
 	}
 	
 	void makePreDel()
 	{
 		if( isStatus(eNotifyDeleted) )
 		{
-			Callee_t::notifyStatusChange(mStatus, eNotifyDeleted);
+			Callee_t::notifyStatusChange(getStatus(), eNotifyDeleted);
 		}
-		mStatus = 0;
+		this->setField(0);
 	}
+
+	uint8_t getStatus() const { return this->getField(); }
 	
 };
 
 
 
+template<typename Callee_t>
+struct StatusNotify : public StatusNotifyFlags // 8 flag bits
+{
+	static const uint8_t flag_bits = 8;
+
+	template<typename derived_t, uint8_t flag_offset>
+	using bind = StatusNotifyModule<Callee_t, derived_t, flag_offset>;
+};
+
+
+
+
+template<typename group_tag, typename derived_t, uint8_t flag_offset>
+struct GroupModule;
+
+// tasks belonging to one of 32 groups, a group is suspended or resumed at once :
+// Group<MyHandler>::setGroupEnabled(eRadio, false);
+// group_tag identifies the group enable mask, i.e. the TaskHandler class : one mask per handler.
+template<typename group_tag>
+struct Group // 5 flag bits
+{
+	static const uint8_t flag_bits = 5;
+
+	template<typename derived_t, uint8_t flag_offset>
+	using bind = GroupModule<group_tag, derived_t, flag_offset>;
+
+	static void setGroupEnabled(uint8_t inGroup, bool inEnabled)
+	{
+		const uint32_t bit = static_cast<uint32_t>(1) << (inGroup & 31);
+		sEnableMask = inEnabled ? sEnableMask|bit : sEnableMask&~bit;
+	}
+
+	static bool isGroupEnabled(uint8_t inGroup)
+	{
+		return (sEnableMask >> (inGroup & 31)) & 1;
+	}
+
+	// one bit per group, all the groups are enabled by default
+	static void setEnableMask(uint32_t inMask) { sEnableMask = inMask; }
+	static uint32_t getEnableMask() { return sEnableMask; }
+
+protected:
+
+	static uint32_t sEnableMask;
+};
+
+template<typename group_tag>
+uint32_t Group<group_tag>::sEnableMask = ~static_cast<uint32_t>(0);
+
+
+
+template<typename group_tag, typename derived_t, uint8_t flag_offset>
+struct GroupModule : public Group<group_tag>, public FlagField<derived_t, flag_offset, 5>
+{
+
+	void setGroup(uint8_t inGroup) { this->setField(inGroup); }
+	uint8_t getGroup() const { return this->getField(); }
+
+	static const uint8_t snapshot_id = SnapshotWriter::eGroup;
+
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put8(getGroup());
+	}
+
+protected:
+
+	template<typename>
+	void init() { this->setField(0); }
+	bool isExeReady() const { return Group<group_tag>::isGroupEnabled(getGroup()); }
+	bool isDelReady() const { return true; }
+	void makePreExe(){}
+	void makePreDel(){}
+	void makePostExe(){}
+};
+
+
+
+
+
+
+
+
+
+
+
+template<typename derived_t, uint8_t flag_offset>
+struct CriticalityModule;
+
+// criticality class of the task, read while the kernel is overloaded (see Kernel::setOverloadControl) :
+//  - eCritical   : never shed
+//  - eDegradable : executed one kernel cycle out of the degrade period
+//  - eSheddable  : suspended
+// the tasks are restored once the overload is over
+struct Criticality // 2 flag bits
+{
+	static const uint8_t flag_bits = 2;
+
+	template<typename derived_t, uint8_t flag_offset>
+	using bind = CriticalityModule<derived_t, flag_offset>;
+
+	enum eClass:uint8_t
+	{
+		eCritical = 0,
+		eDegradable,
+		eSheddable
+	};
+
+	// power of two number of cycles, 4 by default
+	static void setDegradePeriod(cycle_t inPeriod)
+	{
+		getDegradeMask() = inPeriod ? inPeriod-1 : 0;
+	}
+
+protected:
+
+	// function local : the header can be included by several translation units
+	static cycle_t &getDegradeMask()
+	{
+		static cycle_t sDegradeMask = 3;
+		return sDegradeMask;
+	}
+};
+
+
+
+template<typename derived_t, uint8_t flag_offset>
+struct CriticalityModule : public Criticality, public FlagField<derived_t, flag_offset, 2>
+{
+
+	void setCriticality(eClass inClass) { this->setField(inClass); }
+	eClass getCriticality() const { return static_cast<eClass>(this->getField()); }
+
+	static const uint8_t snapshot_id = SnapshotWriter::eCriticality;
+
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put8(getCriticality());
+	}
+
+protected:
+
+	template<typename>
+	void init() { this->setField(eCritical); }
+
+	bool isExeReady() const
+	{
+		if(!SysKernelData::sIsOverloaded)
+		{
+			return true;
+		}
+		switch(getCriticality())
+		{
+			case eCritical: return true;
+			case eDegradable: return !(SysKernelData::sCnt & getDegradeMask());
+			default: return false;
+		}
+	}
+
+	bool isDelReady() const { return true; }
+	void makePreExe(){}
+	void makePreDel(){}
+	void makePostExe(){}
+};
+
+
+
 
 
 
@@ -338,6 +1041,9 @@ protected:
 struct Delay // 4 bytes
 {
 
+	// the readiness only depends on a deadline, see deadline-mask.h
+	static const bool has_deadline = true;
+
 	void setDelay(tick_t inDelay)
 	{
 		mExecution_time_stamp = SysKernelData::sGetTick()+inDelay; 
@@ -345,13 +1051,21 @@ struct Delay // 4 bytes
 	
 	tick_t getDelay()
 	{	
-		if(mExecution_time_stamp > SysKernelData::sGetTick()){
-			return mExecution_time_stamp - SysKernelData::sGetTick(); 
+		tick_t t = SysKernelData::sGetTick();
+		if(!isTickReached(t, mExecution_time_stamp)){
+			return mExecution_time_stamp - t; 
 		}else{
 			return 0;
 		}
 	}
 
+	static const uint8_t snapshot_id = SnapshotWriter::eDelay;
+
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put32(mExecution_time_stamp);
+	}
+
 protected:
 
 	template<typename derived_t>
@@ -362,7 +1076,12 @@ protected:
 	
     bool isExeReady() const 
 	{
-		return (SysKernelData::sGetTick() >= mExecution_time_stamp);
+		return isTickReached(SysKernelData::sGetTick(), mExecution_time_stamp);
+	}
+
+	const tick_t *getDeadline() const
+	{
+		return &mExecution_time_stamp;
 	}
 	
 	bool isDelReady() const { return true; }
@@ -373,45 +1092,428 @@ protected:
 	void makePostExe(){}	
 	
 private:
-	
-	tick_t mExecution_time_stamp;
-	
-};
+	
+	tick_t mExecution_time_stamp = 0;
+	
+};
+
+
+
+
+
+
+// periodic call of the function, guarantees a constant average execution rate
+struct Periodic // 7 bytes
+{
+
+	using period_t = uint16_t;
+
+	// the readiness only depends on a deadline, see deadline-mask.h
+	static const bool has_deadline = true;
+
+	// behaviour when the task runs later than one full period after its release
+	enum eCatchUp:uint8_t
+	{
+		eBurst,		// every missed release is executed, the task catches up
+		eSkip		// the missed releases are dropped
+	};
+	
+	void setPeriod(period_t inPeriod)
+	{
+		mPeriod = inPeriod;
+		mExecution_time_stamp += mPeriod;
+	}
+
+	period_t getPeriod()
+	{
+		return mPeriod;
+	}
+
+	void setCatchUp(eCatchUp inCatchUp)
+	{
+		mCatchUp = inCatchUp;
+	}
+
+	void setDelay(tick_t inDelay)
+	{	
+		mExecution_time_stamp = SysKernelData::sGetTick()+inDelay; 
+	}
+	
+	tick_t getDelay()
+	{	
+		tick_t t = SysKernelData::sGetTick();
+		if(!isTickReached(t, mExecution_time_stamp)){
+			return mExecution_time_stamp - t; 
+		}else{
+			return 0;
+		}
+	}
+
+	static const uint8_t snapshot_id = SnapshotWriter::ePeriodic;
+
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put32(mExecution_time_stamp);
+		ioWriter.put16(mPeriod);
+		ioWriter.put8(mCatchUp);
+	}
+
+protected:
+
+	template<typename derived_t>
+	void init()
+	{
+		mExecution_time_stamp = SysKernelData::sGetTick();
+		mCatchUp = eBurst;
+	}
+	
+	bool isExeReady() const {
+		return isTickReached(SysKernelData::sGetTick(), mExecution_time_stamp);
+	}
+	bool isDelReady() { return true; }
+	void makePreExe()
+	{
+		release(getLateness());
+	}
+	void makePreDel(){}
+	void makePostExe(){}
+
+	const tick_t *getDeadline() const
+	{
+		return &mExecution_time_stamp;
+	}
+
+	// time elapsed since the current release
+	tick_t getLateness() const
+	{
+		return SysKernelData::sGetTick() - mExecution_time_stamp;
+	}
+
+	// schedules the next release, returns the count of missed releases
+	tick_t release(tick_t inLateness)
+	{
+		tick_t missed = 0;
+		if(mPeriod && inLateness >= mPeriod)
+		{
+			missed = inLateness/mPeriod;
+		}
+		
+		if(mCatchUp == eSkip)
+		{
+			mExecution_time_stamp += mPeriod*(missed+1);
+		}else{
+			mExecution_time_stamp += mPeriod;
+		}
+		return missed;
+	}
+	
+	tick_t mExecution_time_stamp = 0;
+	period_t mPeriod = 0;
+	eCatchUp mCatchUp = eBurst;
+};
+
+
+
+
+
+
+// Periodic with timing statistics :
+//  - histogram of the release jitter (delay between release and execution),
+//    the last bucket gathers every jitter above the histogram range
+//  - count of overruns, i.e. executions started more than one period late
+//  - count of releases dropped by the eSkip catch up policy
+// counters saturate at their max value
+template<uint8_t bucket_count, tick_t bucket_width = 1>
+struct PeriodicStats : public Periodic
+{
+	static_assert(bucket_count > 0, "PeriodicStats needs at least one bucket");
+	static_assert(bucket_width > 0, "PeriodicStats bucket width must not be null");
+
+	using counter_t = uint16_t;
+
+	counter_t getJitterCount(uint8_t inBucket)
+	{
+		if(inBucket >= bucket_count){ return 0; }
+		return mHistogram[inBucket];
+	}
+
+	tick_t getMaxJitter()
+	{
+		return mMaxJitter;
+	}
+
+	counter_t getOverrunCount()
+	{
+		return mOverrunCount;
+	}
+
+	counter_t getSkippedCount()
+	{
+		return mSkippedCount;
+	}
+
+	void resetStats()
+	{
+		for(uint8_t i=0 ; i<bucket_count ; i++)
+		{
+			mHistogram[i] = 0;
+		}
+		mMaxJitter = 0;
+		mOverrunCount = 0;
+		mSkippedCount = 0;
+	}
+
+	static const uint8_t snapshot_id = SnapshotWriter::ePeriodicStats;
+
+	// Periodic, then the statistics
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		Periodic::snapshot(ioWriter);
+		ioWriter.put32(mMaxJitter);
+		ioWriter.put16(mOverrunCount);
+		ioWriter.put16(mSkippedCount);
+		for(uint8_t i=0 ; i<bucket_count ; i++)
+		{
+			ioWriter.put16(mHistogram[i]);
+		}
+	}
+
+protected:
+
+	template<typename derived_t>
+	void init()
+	{
+		Periodic::init<derived_t>();
+		resetStats();
+	}
+
+	void makePreExe()
+	{
+		tick_t jitter = getLateness();
+
+		tick_t bucket = jitter/bucket_width;
+		increment(mHistogram[(bucket < bucket_count) ? bucket : bucket_count-1]);
+
+		if(jitter > mMaxJitter){ mMaxJitter = jitter; }
+
+		tick_t missed = release(jitter);
+		if(missed)
+		{
+			increment(mOverrunCount);
+			UCOSM_TRACE(TraceEvent::eOverrun, missed, jitter);
+			if(mCatchUp == eSkip)
+			{
+				mSkippedCount = (mSkippedCount+missed < max_count) ? mSkippedCount+missed : max_count;
+			}
+		}
+	}
+
+private:
+
+	static const counter_t max_count = std::numeric_limits<counter_t>::max();
+
+	static void increment(counter_t &ioCounter)
+	{
+		if(ioCounter != max_count){ ioCounter++; }
+	}
+
+	tick_t mMaxJitter;
+	counter_t mOverrunCount;
+	counter_t mSkippedCount;
+	counter_t mHistogram[bucket_count];
+};
+
+
+
+
+
+
+
+
+// time slice of a long running task :
+// the task checks shouldYield() while processing a batch, returns once the slice is consumed
+// and resumes from its cursor on the next dispatch :
+//
+//	for(uint32_t i = h->getCursor() ; i < count ; i++)
+//	{
+//		if(h->shouldYield()){ h->setCursor(i); return; }
+//		process(i);
+//	}
+//	h->setCursor(0);
+struct TimeSlice // 12 bytes
+{
+
+	static const uint8_t snapshot_id = SnapshotWriter::eTimeSlice;
+
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put32(mSlice);
+		ioWriter.put32(mCursor);
+	}
+
+	// 0 : unlimited slice
+	void setSlice(tick_t inSlice)
+	{
+		mSlice = inSlice;
+	}
+
+	tick_t getSlice()
+	{
+		return mSlice;
+	}
+
+	// true when the slice of the current execution is consumed
+	bool shouldYield() const
+	{
+		return mSlice && isTickReached(SysKernelData::sGetTick(), mSliceEnd);
+	}
+
+	// position of the batch processing, kept between the executions
+	void setCursor(uint32_t inCursor)
+	{
+		mCursor = inCursor;
+	}
+
+	uint32_t getCursor()
+	{
+		return mCursor;
+	}
+
+protected:
+
+	template<typename derived_t>
+	void init()
+	{
+		mSlice = 0;
+		mSliceEnd = 0;
+		mCursor = 0;
+	}
+
+	bool isExeReady() const { return true; }
+	bool isDelReady() const { return true; }
+
+	void makePreExe()
+	{
+		mSliceEnd = SysKernelData::sGetTick() + mSlice;
+	}
+
+	void makePreDel(){}
+	void makePostExe(){}
+
+private:
+
+	tick_t mSlice = 0;
+	tick_t mSliceEnd = 0;
+	uint32_t mCursor = 0;
+};
+
+
+
+
+
+
+// Handler module : bounds the time a handler can spend in a single kernel cycle
+// the handler stops dispatching its tasks once the budget is consumed
+// and resumes from the next task slot on the following cycle.
+// The budget of an enclosing handler (a kernel scheduled by a task) is saved
+// while the handler runs and restored after it
+struct Budget // 16 bytes
+{
+
+	// 0 : unlimited budget
+	void setBudget(tick_t inBudget)
+	{
+		mBudget = inBudget;
+	}
+
+	tick_t getBudget()
+	{
+		return mBudget;
+	}
+
+	// time consumed by the handler during its last cycle
+	tick_t getConsumed()
+	{
+		return mConsumed;
+	}
+
+	static const uint8_t snapshot_id = SnapshotWriter::eBudget;
+
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put32(mBudget);
+		ioWriter.put32(mConsumed);
+	}
+
+protected:
+
+	template<typename derived_t>
+	void init()
+	{
+		mBudget = 0;
+		mConsumed = 0;
+		mSavedBudget = 0;
+		mSavedStart = 0;
+	}
+
+	bool isExeReady() const { return true; }
+	bool isDelReady() const { return true; }
+
+	void makePreExe()
+	{
+		mSavedBudget = SysKernelData::sBudget;
+		mSavedStart = SysKernelData::sBudgetStart;
+		SysKernelData::sBudgetStart = SysKernelData::sGetTick();
+		SysKernelData::sBudget = mBudget;
+	}
+
+	void makePreDel(){}
+
+	void makePostExe()
+	{
+		mConsumed = SysKernelData::sGetTick() - SysKernelData::sBudgetStart;
+		SysKernelData::sBudget = mSavedBudget;
+		SysKernelData::sBudgetStart = mSavedStart;
+	}
+
+private:
 
+	tick_t mBudget = 0;
+	tick_t mConsumed = 0;
+	tick_t mSavedBudget = 0;
+	tick_t mSavedStart = 0;
+};
 
 
 
 
 
-// periodic call of the function, guarantees a constant average execution rate
-struct Periodic // 6 bytes
+// Handler module : time spent by the handler in its cycles,
+// the counters are read and cleared by takeLoad(), i.e. from the kernel report callback
+struct Load // 12 bytes
 {
 
-	using period_t = uint16_t;
+	// time spent since the last takeLoad()
+	tick_t getBusy() { return mBusy; }
 
-	
-	void setPeriod(period_t inPeriod)
-	{
-		mPeriod = inPeriod;
-		mExecution_time_stamp += mPeriod;
-	}
+	// longest cycle of the handler since the last takeLoad()
+	tick_t getLongest() { return mLongest; }
 
-	period_t getPeriod()
+	// returns the time spent since the last call and clears the counters
+	tick_t takeLoad()
 	{
-		return mPeriod;
+		tick_t busy = mBusy;
+		mBusy = 0;
+		mLongest = 0;
+		return busy;
 	}
 
-	void setDelay(tick_t inDelay)
-	{	
-		mExecution_time_stamp = SysKernelData::sGetTick()+inDelay; 
-	}
-	
-	tick_t getDelay()
-	{	if(mExecution_time_stamp > SysKernelData::sGetTick()){
-			return mExecution_time_stamp - SysKernelData::sGetTick(); 
-		}else{
-			return 0;
-		}
+	static const uint8_t snapshot_id = SnapshotWriter::eLoad;
+
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put32(mBusy);
+		ioWriter.put32(mLongest);
 	}
 
 protected:
@@ -419,24 +1521,32 @@ protected:
 	template<typename derived_t>
 	void init()
 	{
-		mExecution_time_stamp = SysKernelData::sGetTick();
-	}
-	
-	bool isExeReady() const {
-		return (SysKernelData::sGetTick() >= mExecution_time_stamp);
+		mBusy = 0;
+		mLongest = 0;
 	}
-	bool isDelReady() { return true; }
+
+	bool isExeReady() const { return true; }
+	bool isDelReady() const { return true; }
+
 	void makePreExe()
 	{
-		mExecution_time_stamp += mPeriod;
+		mStart = SysKernelData::sGetTick();
 	}
+
 	void makePreDel(){}
-	void makePostExe(){}
-		
+
+	void makePostExe()
+	{
+		tick_t duration = SysKernelData::sGetTick() - mStart;
+		mBusy += duration;
+		if(duration > mLongest){ mLongest = duration; }
+	}
+
 private:
-	
-	tick_t mExecution_time_stamp;
-	period_t mPeriod;
+
+	tick_t mStart = 0;
+	tick_t mBusy = 0;
+	tick_t mLongest = 0;
 };
 
 
@@ -446,48 +1556,78 @@ private:
 
 
 
+template<typename T, uint16_t fifo_size, typename derived_t>
+struct SignalModule;
+
 // Allow to send data to a specific task
 // Data is unaccessible if the owner task is not currently running
 template<typename T, uint16_t fifo_size>
 struct Signal
 {
+	static const uint8_t flag_bits = 0;
+
+	template<typename derived_t, uint8_t flag_offset>
+	using bind = SignalModule<T, fifo_size, derived_t>;
 	
 	bool send(Signal *inReceiver, T inData)
 	{
 		if(!inReceiver){return false;}
-		return (inReceiver->mRxData.push(inData));
+		if(!inReceiver->mRxData.push(inData))
+		{
+			UCOSM_TRACE(TraceEvent::eSignalDrop, fifo_size, reinterpret_cast<uintptr_t>(inReceiver));
+			return false;
+		}
+		return true;
 	}
 
-	T receive()
+	bool hasData()
 	{
-		if(!reinterpret_cast<Status *>(this)->isRunning()){
-			return T();
-		}
+		return !mRxData.isEmpty();
+	}
 
-		return mRxData.pop();
+	static const uint8_t snapshot_id = SnapshotWriter::eSignal;
+
+	// fill level and capacity of the fifo
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put16(mRxData.getCount());
+		ioWriter.put16(fifo_size);
 	}
 
-	bool hasData()
+protected:
+	
+	Fifo<T, fifo_size> mRxData;
+};
+
+
+
+template<typename T, uint16_t fifo_size, typename derived_t>
+struct SignalModule : public Signal<T, fifo_size>
+{
+	static_assert(!std::is_void<derived_t>::value, "Signal requires Modules<>");
+
+	T receive()
 	{
-		return !mRxData.isEmpty();
+		if(!static_cast<derived_t *>(this)->isRunning()){
+			return T();
+		}
+
+		return this->mRxData.pop();
 	}
 
 protected:
 
-	template<typename derived_t>
+	template<typename>
 	void init()
 	{ 
-		static_assert(std::is_base_of<Status, derived_t>::value, "Signal must implement Status");
+		static_assert(derived_t::template hasModule<Status>(), "Signal must implement Status");
 	}
 	bool isExeReady() { return true; }
-	bool isDelReady() { return mRxData.isEmpty(); }
+	bool isDelReady() { return this->mRxData.isEmpty(); }
 	void makePreExe() {}
 	void makePreDel() {}
 	void makePostExe(){}
 
-private:
-	
-	Fifo<T, fifo_size> mRxData;
 };
 
 
@@ -495,27 +1635,111 @@ private:
 
 
 
-// contains an element of the specified type
+// contains an element of the specified type, constructed in place when the task is created
+// and destroyed when it is deleted : createTask(&MyClass::process, &handle, arg0, arg1) constructs
+// T(arg0, arg1), without argument T is value-initialized.
+// The arguments go to the first module whose init takes them (see Modules::init) : place Content
+// before another module constructible from the same arguments.
 template<typename T> 
 struct Content
 {	
 	
 	T& getContent()
 	{
-		return content;
+		return *reinterpret_cast<T *>(mContent);
+	}
+	
+protected:
+
+	template<typename derived_t, typename ...Args>
+	typename std::enable_if<std::is_constructible<T, Args&&...>::value>::type init(Args&&... inArgs)
+	{
+		new (mContent) T(std::forward<Args>(inArgs)...);
+	}
+
+	bool isExeReady() const { return true; }
+	bool isDelReady() const { return true; } 
+	void makePreExe(){}
+	void makePreDel()
+	{
+		getContent().~T();
+	}
+	void makePostExe(){}
+
+private:
+
+	alignas(T) uint8_t mContent[sizeof(T)];
+};
+
+
+
+
+
+
+
+// callable executed by the task : createTask([=]{ ... }, &handle) or createTask(&freeFunction)
+// in a TaskHandler declaring Callable in its task modules (Modules<> only).
+// The callable is stored in the task (capacity bytes) and destroyed with the task,
+// a callable deleting its own task is destroyed once it returns.
+template<uint16_t capacity> 
+struct Callable
+{	
+
+	bool hasCallable() const
+	{
+		return static_cast<bool>(mCallable);
+	}
+
+	// called by the TaskHandler
+	void call()
+	{
+		mIsRunning = true;
+		mCallable();
+		mIsRunning = false;
+
+		// deleted by itself : its captures were in use until now
+		if(mIsDeleted)
+		{
+			mIsDeleted = false;
+			mCallable.reset();
+		}
 	}
 	
 protected:
 
 	template<typename derived_t>
-	void init() {}
+	void init()
+	{
+		mCallable.reset();
+		mIsRunning = mIsDeleted = false;
+	}
+
+	template<typename derived_t, typename F>
+	auto init(F &&inCallable) -> decltype(std::declval<typename std::decay<F>::type &>()(), void())
+	{
+		mCallable.assign(std::forward<F>(inCallable));
+		mIsRunning = mIsDeleted = false;
+	}
+
 	bool isExeReady() const { return true; }
 	bool isDelReady() const { return true; } 
 	void makePreExe(){}
-	void makePreDel(){}
+	void makePreDel()
+	{
+		if(mIsRunning)
+		{
+			mIsDeleted = true;
+			return;
+		}
+		mCallable.reset();
+	}
 	void makePostExe(){}
 
-	T content;
+private:
+
+	InplaceFunction<capacity> mCallable;
+	bool mIsRunning;
+	bool mIsDeleted;
 };
 
 
@@ -571,92 +1795,123 @@ protected:
 
 
 
+struct ListItem
+{
+	ListItem* mPrev;
+	ListItem* mNext;
+};
 
 
 
+template<typename list_tag, typename derived_t>
+struct MruListModule;
 
+// intrusive list of the tasks ordered by their last execution.
+// list_tag identifies the list, i.e. the TaskHandler class : one list per handler.
+// The tasks enter the list as the least recent ones when created,
+// move to the front on each execution and leave the list when deleted.
+template<typename list_tag>
+struct MruList : public ListItem // 16 bytes
+{
+	static const uint8_t flag_bits = 0;
 
+	template<typename derived_t, uint8_t flag_offset>
+	using bind = MruListModule<list_tag, derived_t>;
 
+	static bool isEmpty() { return sHead.mNext == &sHead; }
 
+	// LinkedList accessors : the task executed just after and just before this one,
+	// nullptr at the ends of the list
+	ListItem *getNext() { return (mPrev == &sHead) ? nullptr : mPrev; }
+	ListItem *getPrev() { return (mNext == &sHead) ? nullptr : mNext; }
 
+protected:
 
+	// sentinel : sHead.mNext is the most recent task, sHead.mPrev the least recent
+	static ListItem sHead;
+	
+};
 
 
 
-
-
-
-
-
-
-struct ListItem
+template<typename list_tag, typename derived_t>
+struct MruListModule : public MruList<list_tag>
 {
-	ListItem* mPrev;
-	ListItem* mNext;
-};
+	static_assert(!std::is_void<derived_t>::value, "MruList requires Modules<>");
 
+	// nullptr when the list is empty
+	static derived_t *getMostRecent() { return getTask(sHead.mNext); }
+	static derived_t *getLeastRecent() { return getTask(sHead.mPrev); }
 
+	// nullptr at the end of the list
+	derived_t *getOlder() { return getTask(mNext); }
+	derived_t *getNewer() { return getTask(mPrev); }
 
-// automatically updated linked list of tasks by chronology of execution
-template<int listIndex>
-struct LinkedList : public ListItem // 9 bytes
-{
+	static const uint8_t snapshot_id = SnapshotWriter::eMruList;
+
+	// the order of the tasks is not kept
+	void snapshot(SnapshotWriter &) const {}
 
-	ListItem *getNext() { return mNext; }
-	ListItem *getPrev() { return mPrev; }
-	
 protected:
 
-	template<typename derived_t>
+	using MruList<list_tag>::sHead;
+	using MruList<list_tag>::mPrev;
+	using MruList<list_tag>::mNext;
+
+	template<typename>
 	void init()
 	{   
-		static_assert(std::is_base_of<Status, derived_t>::value, "LinkedList must implement Status");
-		mPrev = mNext = nullptr;
+		// least recent
+		mNext = &sHead;
+		mPrev = sHead.mPrev;
+		sHead.mPrev->mNext = this;
+		sHead.mPrev = this;
 	}
 
 	bool isExeReady() const { return true; }
 	bool isDelReady() const { return true; } 
 	void makePreExe()
 	{
-		if(reinterpret_cast<Status *>(this)->isStarted()){return;}
+		if(sHead.mNext == this){ return; }
 
-		if(sTopHandle)
-		{
-			sTopHandle->mNext = this;
-			mPrev = sTopHandle;
-		}
-		sTopHandle = this;
+		unlink();
+		mPrev = &sHead;
+		mNext = sHead.mNext;
+		sHead.mNext->mPrev = this;
+		sHead.mNext = this;
 	}
 	void makePreDel()
 	{
-		if(sTopHandle == this)
-		{
-			if(mPrev){
-				sTopHandle = mPrev;
-			}else{
-				sTopHandle = nullptr;
-			}
-		}
-		if(mPrev && mNext)
-		{
-			mPrev->mNext = mNext;
-			mNext->mPrev = mPrev;
-		}else if(mPrev){
-			mPrev->mNext = nullptr;
-		}else if(mNext){
-			mNext->mPrev = nullptr;
-		}
+		unlink();
+		mPrev = mNext = this;
 	}
 	void makePostExe(){}
 
 private:
 
-	static ListItem *sTopHandle;
+	void unlink()
+	{
+		mPrev->mNext = mNext;
+		mNext->mPrev = mPrev;
+	}
+
+	static derived_t *getTask(ListItem *inItem)
+	{
+		if(inItem == &sHead){ return nullptr; }
+		return static_cast<derived_t *>(static_cast<MruListModule *>(inItem));
+	}
 	
 };
 
+template<typename list_tag>
+ListItem MruList<list_tag>::sHead = {&MruList<list_tag>::sHead, &MruList<list_tag>::sHead};
+
+
+
+// list of the tasks by chronology of execution, shared by all the tasks declaring listIndex.
+// getNext() goes to the more recent tasks, getPrev() to the older ones
 template<int listIndex>
-ListItem *LinkedList<listIndex>::sTopHandle = nullptr;
+using LinkedList = MruList<std::integral_constant<int, listIndex>>;
 
 
 
@@ -705,14 +1960,41 @@ ListItem *LinkedList<listIndex>::sTopHandle = nullptr;
 //  - Forbids task deletion if a buffer is allocated to avoid memory leakage
 //  - The number of buffer per task types has a maximum value of 32
 
+template<typename elem_t, uint16_t elem_count, typename derived_t, uint8_t flag_offset>
+struct MemPool32Module;
+
 template<typename elem_t, uint16_t elem_count>
-struct MemPool32
+struct MemPool32 // 6 flag bits
 {
 	static_assert(elem_count <= 32, "size of pool must not exceed 32");
 	
 	static_assert( (sizeof(elem_t) * sizeof(elem_count) ) > 4, 
 	"Suboptimal implementation : Pool's size inferior to overhead's");
 
+	static const uint8_t flag_bits = 6;
+
+	template<typename derived_t, uint8_t flag_offset>
+	using bind = MemPool32Module<elem_t, elem_count, derived_t, flag_offset>;
+
+protected:
+
+	static elem_t mElems[elem_count];
+	static uint32_t mMemoryMap;
+
+};
+
+template <typename elem_t, uint16_t elem_count>
+elem_t MemPool32<elem_t, elem_count>::mElems[elem_count];
+
+template <typename elem_t, uint16_t elem_count>
+uint32_t MemPool32<elem_t, elem_count>::mMemoryMap = 0;
+
+
+
+template<typename elem_t, uint16_t elem_count, typename derived_t, uint8_t flag_offset>
+struct MemPool32Module : public MemPool32<elem_t, elem_count>, public FlagField<derived_t, flag_offset, 6>
+{
+
 	template<typename T>
 	T *allocate()
 	{
@@ -726,24 +2008,27 @@ struct MemPool32
 	elem_t *allocate()
 	{
 		// pool is full
-		if(mMemoryMap == (1<<elem_count)-1){ return nullptr; }
+		if(mMemoryMap == (1<<elem_count)-1)
+		{
+			UCOSM_TRACE(TraceEvent::ePoolExhausted, elem_count, reinterpret_cast<uintptr_t>(mElems));
+			return nullptr;
+		}
 
 		// task already has allocated memory
-		if(mAllocIndex){ return nullptr; }
+		if(this->getField()){ return nullptr; }
 
 		
 		uint8_t i=0;
 		
 		do{
-			if(!mMemoryMap&(1<<i)) // slot free
+			if(!(mMemoryMap&(1<<i))) // slot free
 			{
 				mMemoryMap |= (1<<i); // take slot
 
-				mAllocIndex = i; // stores the index for fast deletion
-				
+				// stores the index for fast deletion and
 				// set task alloc active with a boolean,
 				// allows to check allocation in case index is 0
-				mAllocIndex |= kAllocBoolMask;
+				this->setField(i | kAllocBoolMask);
 				
 				return &mElems[i];
 			}
@@ -759,20 +2044,20 @@ struct MemPool32
 		if(!mMemoryMap){ return false; }
 
 		// task has no allocated memory
-		if(!mAllocIndex){ return false; }
+		if(!this->getField()){ return false; }
 
 		// remove boolean alloc state
-		mAllocIndex &= ~kAllocBoolMask;
+		uint8_t allocIndex = this->getField() & ~kAllocBoolMask;
 
 		// security check : verify that the memory has been allocated
 		// critical error : map and index does not coincide
-		if(!(mMemoryMap&(1<<mAllocIndex))){ return false; }
+		if(!(mMemoryMap&(1<<allocIndex))){ return false; }
 
 		// release memory
-		mMemoryMap &= ~(1<<mAllocIndex);
+		mMemoryMap &= ~(1<<allocIndex);
 
 		// delete index
-		mAllocIndex = 0;
+		this->setField(0);
 		return true;
 
 	}
@@ -788,37 +2073,40 @@ struct MemPool32
 
 	elem_t *getMemory()
 	{
-		if(!mAllocIndex){ return nullptr; }
-		return &mElems[mAllocIndex&(~kAllocBoolMask)];
+		if(!this->getField()){ return nullptr; }
+		return &mElems[this->getField()&(~kAllocBoolMask)];
+	}
+
+	static const uint8_t snapshot_id = SnapshotWriter::eMemPool32;
+
+	// allocated flag and buffer index, then the map of the pool
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put8(this->getField());
+		ioWriter.put32(this->mMemoryMap);
 	}
 
 protected:
 
-	template<typename derived_t>
-	void init() { mAllocIndex = 0; }
+	using MemPool32<elem_t, elem_count>::mElems;
+	using MemPool32<elem_t, elem_count>::mMemoryMap;
+
+	template<typename>
+	void init() { this->setField(0); }
 	bool isExeReady() const { return true; }
 	
 	// decide if deletion forbidden if allocated memory or auto release?
-	bool isDelReady() const { return !mAllocIndex; } 
+	bool isDelReady() const { return !this->getField(); } 
 	void makePreExe(){}
 	void makePreDel(){}
 	void makePostExe(){}
 	
 private:
 
-	uint8_t mAllocIndex;
-	
-	static elem_t mElems[elem_count];
-	static uint32_t mMemoryMap;
-	static const uint8_t kAllocBoolMask = 0b10000000;
+	static const uint8_t kAllocBoolMask = 0b00100000;
 
 };
 
-template <typename elem_t, uint16_t elem_count>
-elem_t MemPool32<elem_t, elem_count>::mElems[elem_count];
-
-template <typename elem_t, uint16_t elem_count>
-uint32_t MemPool32<elem_t, elem_count>::mMemoryMap = 0;
 
 
 
@@ -831,31 +2119,63 @@ uint32_t MemPool32<elem_t, elem_count>::mMemoryMap = 0;
 
 
 
+template<typename derived_t, uint8_t flag_offset>
+struct ParentModule;
 
 // allows to set a Parent/Child relation between two tasks,
 // it forbids the deletion of the parent task if the child is alive
-struct Parent
+struct Parent // 1 flag bit
+{
+	static const uint8_t flag_bits = 1;
+
+	template<typename derived_t, uint8_t flag_offset>
+	using bind = ParentModule<derived_t, flag_offset>;
+
+private:
+
+	template<typename derived_t, uint8_t flag_offset>
+	friend struct ParentModule;
+
+	union{
+		Parent *mChild;
+		Parent *mParent;
+	};
+};
+
+
+
+template<typename derived_t, uint8_t flag_offset>
+struct ParentModule : public Parent, public FlagField<derived_t, flag_offset, 1>
 {
 
 	void setChild(Parent *inChild)
 	{
 		inChild->mParent = this;
 		mChild = inChild;
-		mIsParent = true;
+		setIsParent(true);
 	}
 	
+	static const uint8_t snapshot_id = SnapshotWriter::eParent;
+
+	// parent flag, then 1 if the child (or parent) is set
+	void snapshot(SnapshotWriter &ioWriter) const
+	{
+		ioWriter.put8(isParent());
+		ioWriter.put8(mChild != nullptr);
+	}
+
 protected:
 
-	template<typename derived_t>
+	template<typename>
 	void init()
 	{ 
-		mIsParent = false;
+		setIsParent(false);
 		mChild = nullptr; 
 	}
 	bool isExeReady() const { return true; }
 	bool isDelReady()
 	{
-		if(!mIsParent) { return true; }
+		if(!isParent()) { return true; }
 		
 		if(!mChild)	{ return true; }
 	
@@ -864,7 +2184,7 @@ protected:
 	void makePreExe(){}
 	void makePreDel()
 	{
-		if(!mIsParent && mParent)
+		if(!isParent() && mParent)
 		{
 			mParent->mChild = nullptr;
 		}
@@ -873,12 +2193,8 @@ protected:
 
 private:
 
-	union{
-		Parent *mChild;
-		Parent *mParent;
-	};
-	
-	bool mIsParent;
+	bool isParent() const { return this->getField(); }
+	void setIsParent(bool inIsParent) { this->setField(inIsParent); }
 };
 
 
@@ -889,12 +2205,19 @@ private:
 
 
 
+template<typename derived_t>
+struct CoroutineModule;
+
 // Be careful with this one!
 // It should not be employed in an infinite loop
 // It will mess up thisTaskHandle()
 // You'll have to store the current task value
 struct Coroutine
 {
+	static const uint8_t flag_bits = 0;
+
+	template<typename derived_t, uint8_t flag_offset>
+	using bind = CoroutineModule<derived_t>;
 
 	void waitFor(tick_t inDuration)
 	{
@@ -903,19 +2226,27 @@ struct Coroutine
 			SysKernelData::sMaster->schedule(inDuration);	
 		}
 	}
-						
+	
+};
+
+
+
+template<typename derived_t>
+struct CoroutineModule : public Coroutine
+{
+	static_assert(!std::is_void<derived_t>::value, "Coroutine requires Modules<>");
 
 protected:
 
-	template<typename derived_t>
+	template<typename>
 	void init()
 	{ 
-		static_assert(std::is_base_of<Status, derived_t>::value, "Coroutine must implement Status");
+		static_assert(derived_t::template hasModule<Status>(), "Coroutine must implement Status");
 	}
 	
 	bool isExeReady() 
 	{ 
-		return !(reinterpret_cast<Status *>(this)->isRunning());
+		return !(static_cast<derived_t *>(this)->isRunning());
 	}
 	
 	bool isDelReady()
@@ -926,8 +2257,6 @@ protected:
 	void makePreExe(){}
 	void makePreDel(){}
 	void makePostExe(){}
-
-private:
 	
 };
 
@@ -960,19 +2289,17 @@ struct Coroutine2
 
 
 	
-	template<typename T>
-	T *getContext()
+	// the context is constructed in place with inArgs when the coroutine starts (line 0),
+	// the previous context is destroyed first (CR_RESET) and the last one when the task is deleted
+	template<typename T, typename ...Args>
+	T *getContext(Args&&... inArgs)
 	{
-		static_assert(sizeof(T) <= sizeof(mContext), "Coroutine context size error");
+		static_assert(sizeof(T) <= max_context_size, "Coroutine context size error");
+		static_assert(alignof(T) <= alignof(std::max_align_t), "Coroutine context alignment error");
 		if(!line){
-			// instantiate T inside context buffer
-			T temp;
-			uint8_t *dest = mContext;
-			uint8_t *src = reinterpret_cast<uint8_t *>(&temp);
-			const uint8_t *end = src+sizeof(T);
-			while(src != end){
-				*dest++ = *src++;
-			}
+			destroyContext();
+			new (mContext) T(std::forward<Args>(inArgs)...);
+			mDestroy = &destroy<T>;
 		}
 		return reinterpret_cast<T *>(mContext);
 	}
@@ -982,16 +2309,33 @@ struct Coroutine2
 protected:
 
 	template<typename derived_t>
-	void init() { line = 0;}
+	void init() { line = 0; mDestroy = nullptr; }
 	bool isExeReady() const { return true; }
 	bool isDelReady() const { return true; } 
 	void makePreExe(){}
-	void makePreDel(){}
+	void makePreDel(){ destroyContext(); }
 	void makePostExe(){}
 
 private:
+
+	template<typename T>
+	static void destroy(void *inContext)
+	{
+		static_cast<T *>(inContext)->~T();
+	}
+
+	void destroyContext()
+	{
+		if(mDestroy)
+		{
+			mDestroy(mContext);
+			mDestroy = nullptr;
+		}
+	}
 	
-	uint8_t mContext[max_context_size];
+	alignas(std::max_align_t) uint8_t mContext[max_context_size];
+
+	void (*mDestroy)(void *);
 	
 	
 };
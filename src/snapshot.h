@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2020 Thomas AUBERT <aubert.thms@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name ``Thomas AUBERT'' nor the name of any other
+ *    contributor may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 
+ * uCosmDev IS PROVIDED BY Thomas AUBERT ``AS IS'' AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL Thomas AUBERT OR ANY OTHER CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#pragma once
+
+#include "stdint.h"
+#include <cstddef>
+#include <cstring>
+
+
+
+
+// Binary snapshot of the scheduler state, see Kernel::takeSnapshot()
+// decoded by tools/snapshot-decode.cc. Little endian, version 3 :
+//
+//  header    : 'u' 'C' 'S' 'M', version, pointer size, tick (4), kernel cycle (4)
+//  kernel    : 'K', index size, handler count (index size), cycles (4), idle cycles (4), busy (4), longest cycle (4), period (4),
+//              then for each handler : handler modules, scheduler
+//  scheduler : 'T', index size, task count, current task index, next task index (index size each),
+//              then for each slot : occupied (1) [function address (pointer size), task modules]
+//              'N' : scheduler without snapshot
+//  modules   : module count, then for each module : id, length (2), state (length bytes)
+//              the state of a module without snapshot() is its raw memory (id 0), truncated to 65535 bytes
+struct SnapshotWriter
+{
+
+	static const uint8_t version = 3;
+
+	enum eRecord:uint8_t
+	{
+		eKernel				= 'K',
+		eTaskHandler		= 'T',
+		eNoSnapshot			= 'N'
+	};
+
+	// ids of the modules states
+	enum eModuleId:uint8_t
+	{
+		eRaw = 0,
+		ePrio,
+		eStatus,
+		eStatusNotify,
+		eGroup,
+		eDelay,
+		ePeriodic,
+		ePeriodicStats,
+		eBudget,
+		eLoad,
+		eSignal,
+		eMemPool32,
+		eParent,
+		eDataflow,
+		eMruList,
+		eIoWait,
+		eTimeSlice,
+		eCriticality,
+		ePingPongBuffer,
+		eStreamBuffer,
+		eAgingPrio
+	};
+
+	SnapshotWriter(uint8_t *outBuffer, size_t inSize) : 
+		mBuffer(outBuffer), mSize(inSize), mPosition(0), mIsOverflow(false)
+	{}
+
+	void putHeader(uint32_t inTick, uint32_t inCycle)
+	{
+		put8('u'); put8('C'); put8('S'); put8('M');
+		put8(version);
+		put8(sizeof(void *));
+		put32(inTick);
+		put32(inCycle);
+	}
+
+	void put8(uint8_t inValue)
+	{
+		if(mPosition < mSize)
+		{
+			mBuffer[mPosition++] = inValue;
+		}else{
+			mIsOverflow = true;
+		}
+	}
+
+	void put16(uint16_t inValue)
+	{
+		put8(static_cast<uint8_t>(inValue));
+		put8(static_cast<uint8_t>(inValue >> 8));
+	}
+
+	void put32(uint32_t inValue)
+	{
+		put16(static_cast<uint16_t>(inValue));
+		put16(static_cast<uint16_t>(inValue >> 16));
+	}
+
+	// index of inSize bytes
+	void putIndex(uint32_t inIndex, uint8_t inSize)
+	{
+		for(uint8_t i=0 ; i<inSize ; i++)
+		{
+			put8(static_cast<uint8_t>(inIndex >> (8*i)));
+		}
+	}
+
+	// inSize bytes of inData, in memory order
+	void putBytes(const void *inData, size_t inSize)
+	{
+		const uint8_t *data = static_cast<const uint8_t *>(inData);
+		for(size_t i=0 ; i<inSize ; i++)
+		{
+			put8(data[i]);
+		}
+	}
+
+	// address held in the first pointer of inObject (function, member function)
+	template<typename T>
+	void putAddress(const T &inObject)
+	{
+		static_assert(sizeof(T) >= sizeof(void *), "Address object smaller than a pointer");
+		uint8_t address[sizeof(void *)];
+		memcpy(address, &inObject, sizeof(address));
+		putBytes(address, sizeof(address));
+	}
+
+	size_t getPosition() const { return mPosition; }
+
+	// overwrites a byte already written, i.e. a length
+	void patch8(size_t inPosition, uint8_t inValue)
+	{
+		if(inPosition < mPosition)
+		{
+			mBuffer[inPosition] = inValue;
+		}
+	}
+
+	// overwrites two bytes already written
+	void patch16(size_t inPosition, uint16_t inValue)
+	{
+		patch8(inPosition, static_cast<uint8_t>(inValue));
+		patch8(inPosition + 1, static_cast<uint8_t>(inValue >> 8));
+	}
+
+	// size of the snapshot, 0 if the buffer is too small
+	size_t getSize() const { return mIsOverflow ? 0 : mPosition; }
+
+private:
+
+	uint8_t *mBuffer;
+	size_t mSize;
+	size_t mPosition;
+	bool mIsOverflow;
+};
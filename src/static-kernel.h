@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2020 Thomas AUBERT <aubert.thms@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name ``Thomas AUBERT'' nor the name of any other
+ *    contributor may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 
+ * uCosmDev IS PROVIDED BY Thomas AUBERT ``AS IS'' AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL Thomas AUBERT OR ANY OTHER CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#pragma once
+
+#include <tuple>
+#include <utility>
+
+#include "modules.h"
+
+#include "uscosm-sys-data.h"
+
+
+
+
+// Kernel whose handlers are fixed at compile time :
+//  - the handlers are held by reference and their schedule() is called directly,
+//    it is not virtual once declared final (TaskHandler, StaticTaskHandler)
+//  - the handler modules are initialized by start() which is called by
+//    the first schedule() if not done before
+//  - use Kernel for a dynamic registration of the handlers
+template<typename handler_t, typename ...Handlers> 
+class StaticKernel : public iScheduler
+{
+
+	static const index_t handler_count = sizeof...(Handlers);
+
+	static_assert(handler_count < max_index-1 , "Handler count too high");	
+
+public:
+
+	constexpr StaticKernel(Handlers&... inHandlers) : 
+		mHandlers(inHandlers...), mHandlerTraits{}, mIdleTask(nullptr), mStarted(false)
+	{}
+
+	void start()
+	{
+		for(index_t i=0 ; i<handler_count ; i++)
+		{
+			mHandlerTraits[i].init();
+		}
+		mStarted = true;
+	}
+
+	template<index_t I>
+	handler_t *getHandle()
+	{
+		static_assert(I < handler_count, "Handler index out of range");
+		return &mHandlerTraits[I];
+	}
+
+	bool schedule(tick_t inMinDuration = 0)
+	{
+		if(!mStarted){ start(); }
+
+		bool fullCycleExe = false;
+		tick_t startTick = SysKernelData::sGetTick();
+		
+		do
+		{
+			SysKernelData::sCnt++;
+
+			// no execution occured during this cycle
+			if(!dispatch(std::make_index_sequence<handler_count>())) 
+			{
+				if(mIdleTask)
+				{
+					// idle task if exists
+					mIdleTask();
+				}
+			}else{
+				// at least one execution occured
+				fullCycleExe = true;
+			}
+			
+		}while( ( SysKernelData::sGetTick() - startTick ) < inMinDuration );
+
+		return fullCycleExe;
+	}
+
+	// earliest wake up tick of the handlers, see Kernel::getWakeTick
+	bool getWakeTick(tick_t inTick, tick_t &outWake)
+	{
+		// not started : polled until the first schedule()
+		if(!mStarted)
+		{
+			outWake = inTick;
+			return true;
+		}
+
+		return getWakeTick(inTick, outWake, std::make_index_sequence<handler_count>());
+	}
+
+	// see Kernel::takeSnapshot(), the statistics are not recorded
+	size_t takeSnapshot(uint8_t *outBuffer, size_t inSize)
+	{
+		SnapshotWriter writer(outBuffer, inSize);
+		writer.putHeader(SysKernelData::sGetTick(), SysKernelData::sCnt);
+		snapshot(writer);
+		return writer.getSize();
+	}
+
+	void snapshot(SnapshotWriter &ioWriter)
+	{
+		ioWriter.put8(SnapshotWriter::eKernel);
+		ioWriter.put8(sizeof(index_t));
+		ioWriter.putIndex(handler_count, sizeof(index_t));
+		for(uint8_t i=0 ; i<5 ; i++)
+		{
+			ioWriter.put32(0);
+		}
+		snapshotHandlers(ioWriter, std::make_index_sequence<handler_count>());
+	}
+
+	void setIdleTask(void (*inIdleTask)())
+ 	{
+		mIdleTask = inIdleTask;
+	}
+
+
+private:
+
+	template<std::size_t... I>
+	bool dispatch(std::index_sequence<I...>)
+	{
+		bool exe[] = {false, execute<I>()...};
+
+		bool singleCycleExe = false;
+		for(index_t i=0 ; i<sizeof(exe) ; i++)
+		{
+			singleCycleExe |= exe[i];
+		}
+		return singleCycleExe;
+	}
+
+	template<std::size_t I>
+	bool execute()
+	{
+		if(!mHandlerTraits[I].isExeReady()){ return false; }
+
+		mHandlerTraits[I].makePreExe();
+		bool hasExe = std::get<I>(mHandlers).schedule();
+		mHandlerTraits[I].makePostExe();
+		return hasExe;
+	}
+
+	template<std::size_t... I>
+	bool getWakeTick(tick_t inTick, tick_t &outWake, std::index_sequence<I...>)
+	{
+		bool isTimed = false;
+		uint8_t d[] = {(uint8_t)0, (mergeWakeTick<I>(inTick, outWake, isTimed), (uint8_t)0)...};
+		static_cast<void>(d); // avoid warning for unused variable
+		return isTimed;
+	}
+
+	template<std::size_t I>
+	void mergeWakeTick(tick_t inTick, tick_t &ioWake, bool &ioIsTimed)
+	{
+		tick_t handlerWake, taskWake;
+		if(mHandlerTraits[I].getWakeTick(inTick, handlerWake) && std::get<I>(mHandlers).getWakeTick(inTick, taskWake))
+		{
+			tick_t wake = getLatestTick(handlerWake, taskWake);
+			ioWake = ioIsTimed ? getEarliestTick(ioWake, wake) : wake;
+			ioIsTimed = true;
+		}
+	}
+
+	template<std::size_t... I>
+	void snapshotHandlers(SnapshotWriter &ioWriter, std::index_sequence<I...>)
+	{
+		uint8_t d[] = {(uint8_t)0, (mHandlerTraits[I].snapshot(ioWriter), std::get<I>(mHandlers).snapshot(ioWriter), (uint8_t)0)...};
+		static_cast<void>(d); // avoid warning for unused variable
+	}
+
+	std::tuple<Handlers&...> mHandlers;
+
+	handler_t mHandlerTraits[handler_count];
+
+	void (*mIdleTask)();
+
+	bool mStarted;
+
+};
+
+
+
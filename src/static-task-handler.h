@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2020 Thomas AUBERT <aubert.thms@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name ``Thomas AUBERT'' nor the name of any other
+ *    contributor may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 
+ * uCosmDev IS PROVIDED BY Thomas AUBERT ``AS IS'' AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL Thomas AUBERT OR ANY OTHER CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+
+#include <utility>
+
+#include "modules.h"
+
+
+
+// compile time list of the tasks of a StaticTaskHandler
+template<typename Caller_t, void (Caller_t::*...task_functions)()>
+struct TaskList
+{
+	static const index_t count = sizeof...(task_functions);
+};
+
+// I-th function of a TaskList
+template<index_t I, typename task_list>
+struct TaskAt;
+
+template<index_t I, typename Caller_t, void (Caller_t::*first)(), void (Caller_t::*...others)()>
+struct TaskAt<I, TaskList<Caller_t, first, others...>> : public TaskAt<I-1, TaskList<Caller_t, others...>>
+{};
+
+template<typename Caller_t, void (Caller_t::*first)(), void (Caller_t::*...others)()>
+struct TaskAt<0, TaskList<Caller_t, first, others...>>
+{
+	static constexpr void (Caller_t::*function)() = first;
+};
+
+
+
+// Task handler whose tasks are fixed at compile time :
+//  - the caller declares its tasks with "using task_list = TaskList<Caller_t, &Caller_t::foo, ...>;"
+//  - the dispatch sequence is unrolled, each task is called directly (no function table)
+//  - the handler is constant-initialized : the modules start from their default member
+//    initializers, i.e. the init() state at cycle 0 and tick 0 (see modules.h), no code runs at startup
+//  - tasks can not be created or deleted, use Status to suspend them
+//  - when the handler budget is consumed, the next cycle resumes from the following task
+template<typename Caller_t, typename task_modules, index_t task_count>
+class StaticTaskHandler : public iScheduler
+{
+	
+	static_assert(task_count < max_index-1 , "Task count too high");	
+
+	using task_t = task_modules;
+
+	// result of the dispatch sequence
+	enum eDispatch:uint8_t
+	{
+		eExecuted	= 1,
+		eStopped	= 2
+	};
+
+public:
+	
+	using TaskHandle = task_t*;
+
+	constexpr StaticTaskHandler() : 
+		mTasks{}, mCurrHandleIndex(max_index), mNextIndex(0)
+	{
+		static_assert((task_t(), true), "Task modules must be constant-initialized");
+	}
+	
+	// final : allows StaticKernel to call it without the virtual dispatch
+	bool schedule(tick_t = 0) final
+	{
+		static_assert(Caller_t::task_list::count == task_count, "Task list size does not match task count");
+
+		// from the slot where the budget stopped the previous cycle to the last one,
+		// then the slots before it
+		index_t from = mNextIndex;
+		index_t to = task_count;
+		mNextIndex = 0;
+
+		uint8_t result = 0;
+		for(;;)
+		{
+			result |= dispatch(std::make_index_sequence<task_count>(), from, to);
+			if((result & eStopped) || !from){ break; }
+			to = from;
+			from = 0;
+		}
+		return (result & eExecuted) != 0;
+	}
+
+	// earliest wake up tick of the tasks
+	bool getWakeTick(tick_t inTick, tick_t &outWake) final
+	{
+		bool isTimed = false;
+		for(index_t i=0 ; i<task_count ; i++)
+		{
+			tick_t wake;
+			if(mTasks[i].getWakeTick(inTick, wake))
+			{
+				outWake = isTimed ? getEarliestTick(outWake, wake) : wake;
+				isTimed = true;
+				if(outWake == inTick){ break; }
+			}
+		}
+		return isTimed;
+	}
+
+	// writes the state of the tasks, see snapshot.h
+	void snapshot(SnapshotWriter &ioWriter) final
+	{
+		ioWriter.put8(SnapshotWriter::eTaskHandler);
+		ioWriter.put8(sizeof(index_t));
+		ioWriter.putIndex(task_count, sizeof(index_t));
+		ioWriter.putIndex(mCurrHandleIndex, sizeof(index_t));
+		ioWriter.putIndex(mNextIndex, sizeof(index_t));
+		snapshotTasks(typename Caller_t::task_list(), ioWriter);
+	}
+
+	TaskHandle getTaskHandle(index_t inIndex)
+	{
+		if(inIndex >= task_count){ return nullptr; }
+		return &mTasks[inIndex];
+	}
+	
+	TaskHandle thisTaskHandle()
+	{
+		if(mCurrHandleIndex == max_index)
+		{
+			catchException("thisTask() not allowed in this context");
+			return 0;
+		}
+		return &mTasks[mCurrHandleIndex];
+	}
+
+private:
+
+	// tasks inFrom to inTo-1, up to the one consuming the handler budget
+	template<std::size_t... I>
+	uint8_t dispatch(std::index_sequence<I...>, index_t inFrom, index_t inTo)
+	{
+		uint8_t result = 0;
+		uint8_t d[] = {(uint8_t)0, (result |= (I < inFrom || I >= inTo || (result & eStopped)) ? 0 : execute<I>())...};
+		static_cast<void>(d);
+		return result;
+	}
+
+	template<index_t I>
+	uint8_t execute()
+	{
+		if(!mTasks[I].isExeReady()){ return 0; }
+
+		mCurrHandleIndex = I;
+		UCOSM_TRACE(TraceEvent::eDispatch, I, reinterpret_cast<uintptr_t>(this));
+		mTasks[I].makePreExe();
+		(static_cast<Caller_t *>(this)->*TaskAt<I, typename Caller_t::task_list>::function)();
+		mTasks[I].makePostExe();
+		mCurrHandleIndex = max_index;
+
+		// handler budget consumed : resume from the next slot on the next cycle
+		if(SysKernelData::sIsBudgetExhausted())
+		{
+			mNextIndex = (I+1 < task_count) ? I+1 : 0;
+			return eExecuted | eStopped;
+		}
+		return eExecuted;
+	}
+
+	template<void (Caller_t::*...task_functions)()>
+	void snapshotTasks(TaskList<Caller_t, task_functions...>, SnapshotWriter &ioWriter)
+	{
+		void (Caller_t::*functions[])() = {task_functions...};
+
+		for(index_t i=0 ; i<task_count ; i++)
+		{
+			ioWriter.put8(true);
+			ioWriter.putAddress(functions[i]);
+			mTasks[i].snapshot(ioWriter);
+		}
+	}
+
+	virtual void catchException(const char *){}
+
+	task_t mTasks[task_count];
+
+	index_t mCurrHandleIndex;
+
+	index_t mNextIndex;
+		
+};
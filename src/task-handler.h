@@ -30,63 +30,108 @@
 #pragma once
 
 
-#include "modules.h"
+#include "task-storage.h"
 
 
 
-template<typename Caller_t, typename task_modules, index_t task_count>
+// task_count : max number of simultaneous tasks
+// index_type : type of the task indexes, by default the smallest one addressing task_count slots
+template<typename Caller_t, typename task_modules, uint32_t task_count, 
+	typename index_type = typename IndexType<task_count>::type>
 class TaskHandler : public iScheduler
 {
 	
+	static const index_type max_index = std::numeric_limits<index_type>::max();
+
 	static_assert(task_count < max_index-1 , "Task count too high");	
 	
 	using task_function_t = void (Caller_t::*)();
 
-	struct TaskItem : public task_modules
-	{
-		constexpr TaskItem(): index(sCounterIndex++) {}
-		const index_t index;
-		static index_t sCounterIndex;
-	};
-
-	using task_t = TaskItem;
+	using storage_t = TaskStorage<Caller_t, task_modules, task_count, index_type>;
 
 public:
 	
-	using TaskHandle = task_t*;
+	using TaskHandle = typename storage_t::TaskHandle;
 
-	TaskHandler()
+	TaskHandler() : mCurrHandleIndex(max_index), mNextIndex(0)
  	{
-		for(index_t i=0 ; i<task_count ; i++)
+		if(!mTasks.isValid())
 		{
-			if(mTasks[i].index != i)
-			{
-				catchException("Critical declaration error");
-				while(1){}
-			}
+			catchException("Critical declaration error");
+			while(1){}
+		}
+		for(index_type i=0 ; i<task_count ; i++)
+		{
+			mFunctions[i] = nullptr;
 		}
+		for(uint32_t k=0 ; k<mask_words ; k++)
+		{
+			mOccupied[k] = 0;
+		}
+		mFreeWord = 0;
 	}
 	
-	bool schedule(tick_t t)
+	// final : allows StaticKernel to call it without the virtual dispatch
+	bool schedule(tick_t = 0) final
 	{
+		if(storage_t::has_deadlines)
+		{
+			return scheduleMask();
+		}
+		if(storage_t::has_priority)
+		{
+			return scheduleRank();
+		}
 
 		bool hasExe = false;
 		
-		index_t i=0;
-		
-		do{
-			if(mFunctions[i] && mTasks[i].isExeReady())
+		// only the occupied slots are visited,
+		// starting from the slot where the previous cycle stopped
+		index_type from = mNextIndex;
+		if(executeMask(mOccupied, from, task_count, hasExe))
+		{
+			executeMask(mOccupied, 0, from, hasExe);
+		}
+		return hasExe;
+	}
+	
+	// earliest wake up tick of the tasks
+	bool getWakeTick(tick_t inTick, tick_t &outWake) final
+	{
+		bool isTimed = false;
+		for(uint32_t w=0 ; w<mask_words ; w++)
+		{
+			for(uint32_t bits = mOccupied[w] ; bits ; bits &= bits-1)
 			{
-				mCurrHandleIndex = i;
-				mTasks[i].makePreExe();
-				(static_cast<Caller_t *>(this)->*mFunctions[i])();
-				mTasks[i].makePostExe();
-				mCurrHandleIndex = max_index;
-				hasExe = true;
+				tick_t wake;
+				if(mTasks.getWakeTick(w*32 + countTrailingZeros(bits), inTick, wake))
+				{
+					outWake = isTimed ? getEarliestTick(outWake, wake) : wake;
+					isTimed = true;
+					if(outWake == inTick){ return true; }
+				}
 			}
-		}while(++i < task_count);
-		
-		return hasExe;
+		}
+		return isTimed;
+	}
+	
+	// writes the state of the tasks, see snapshot.h
+	void snapshot(SnapshotWriter &ioWriter) final
+	{
+		ioWriter.put8(SnapshotWriter::eTaskHandler);
+		ioWriter.put8(sizeof(index_type));
+		ioWriter.putIndex(task_count, sizeof(index_type));
+		ioWriter.putIndex(mCurrHandleIndex, sizeof(index_type));
+		ioWriter.putIndex(mNextIndex, sizeof(index_type));
+		for(index_type i=0 ; i<task_count ; i++)
+		{
+			ioWriter.put8(mFunctions[i] != nullptr);
+			if(mFunctions[i])
+			{
+				ioWriter.putAddress(mFunctions[i]);
+				mTasks.snapshot(i, ioWriter);
+			}
+		}
 	}
 	
 	TaskHandle thisTaskHandle()
@@ -96,63 +141,90 @@ public:
 			catchException("thisTask() not allowed in this context");
 			return 0;
 		}
-		return &mTasks[mCurrHandleIndex];
+		return mTasks.getHandle(mCurrHandleIndex);
 	}
 	
-	bool createTask(task_function_t inFunc, TaskHandle *ioHandle = nullptr)
+	// inArgs are given to the init of the task modules taking them (see Content)
+	template<typename ...Args>
+	bool createTask(task_function_t inFunc, TaskHandle *ioHandle = nullptr, Args&&... inArgs)
 	{					
 				
-		// allocation
-		index_t i=0;
-		do
+		// allocation : first free slot of the occupancy map
+		for(uint32_t w=mFreeWord ; w<mask_words ; w++)
 		{
-			if(!mFunctions[i])
+			uint32_t freeBits = ~mOccupied[w];
+			if(!freeBits)
 			{
-				mFunctions[i] = inFunc;
-				if(ioHandle != nullptr)
-				{
-					*ioHandle = &mTasks[i];
-					mHandlePtr[i] = ioHandle;
-				}else{
-					mHandlePtr[i] = nullptr;
-				}
-				mTasks[i].init();
-				return true;
+				// only the full words move mFreeWord
+				if(mFreeWord == w){ mFreeWord = w+1; }
+				continue;
 			}
-		}while(++i < task_count);
+			// the slot of the running task is not reused while it runs, even if it deleted itself
+			if(mCurrHandleIndex != max_index && mCurrHandleIndex/32 == w)
+			{
+				freeBits &= ~(static_cast<uint32_t>(1) << (mCurrHandleIndex%32));
+				if(!freeBits){ continue; }
+			}
+
+			index_type i = w*32 + countTrailingZeros(freeBits);
+			if(i >= task_count){ return false; }
+
+			mFunctions[i] = inFunc;
+			mOccupied[w] |= static_cast<uint32_t>(1) << (i%32);
+			if(ioHandle != nullptr)
+			{
+				*ioHandle = mTasks.getHandle(i);
+				mHandlePtr[i] = ioHandle;
+			}else{
+				mHandlePtr[i] = nullptr;
+			}
+			mTasks.init(i, std::forward<Args>(inArgs)...);
+			return true;
+		}
 
 		return false;
 	}
 
+	// callable task : function pointer or lambda, stored in the Callable module of the task
+	template<typename F, typename = typename std::enable_if<!std::is_convertible<F, task_function_t>::value>::type>
+	bool createTask(F &&inCallable, TaskHandle *ioHandle = nullptr)
+	{
+		return createTask(&TaskHandler::executeCallable, ioHandle, std::forward<F>(inCallable));
+	}
+
 	bool deleteTask(TaskHandle inHandle)
 	{
 		if(!inHandle){ return false; }
 		
-		index_t i = inHandle->index;
+		index_type i = mTasks.getIndex(inHandle);
 
-		if(mTasks[i].isDelReady())
+		if(!mFunctions[i] || !mTasks.isDelReady(i))
 		{
+			return false;
+		}
 			
-			mTasks[i].makePreDel();
-			mFunctions[i] = nullptr;
-			
-			if(mHandlePtr[i] && *mHandlePtr[i]==&mTasks[i])
-			{
-				*mHandlePtr[i] = nullptr;
-			}
-			
-			mHandlePtr[i] = nullptr;
+		mTasks.makePreDel(i);
+		mFunctions[i] = nullptr;
+		mOccupied[i/32] &= ~(static_cast<uint32_t>(1) << (i%32));
+		if(i/32 < mFreeWord){ mFreeWord = i/32; }
+		
+		if(mHandlePtr[i] && *mHandlePtr[i]==mTasks.getHandle(i))
+		{
+			*mHandlePtr[i] = nullptr;
 		}
+		
+		mHandlePtr[i] = nullptr;
+		return true;
 	}
 
 	 // task tokenizer : can be called several times
 	bool getNextTaskHandle(task_function_t inFunc, TaskHandle *ioHandle)
  	{
-		static index_t sI = 0;
-		for(index_t k=0 ; k<task_count ; k++){
-			sI = (sI+1)%task_count;
+		static index_type sI = 0;
+		for(index_type k=0 ; k<task_count ; k++){
+			sI = (static_cast<uint32_t>(sI)+1 < task_count) ? sI+1 : 0;
 			if(mFunctions[sI] == inFunc){
-				*ioHandle = &mTasks[sI];
+				*ioHandle = mTasks.getHandle(sI);
 				mHandlePtr[sI] = ioHandle;
 				return true;
 			}
@@ -163,19 +235,162 @@ public:
  
 private:
 
-	virtual void catchException(const char *inErrMsg){}
+	static const uint32_t mask_words = (task_count+31)/32;
+
+	// executes the task of slot i if it is ready
+	// returns false when the handler budget is consumed
+	bool execute(index_type i, bool &ioHasExe)
+	{
+		if(mFunctions[i] && mTasks.isExeReady(i))
+		{
+			mCurrHandleIndex = i;
+			UCOSM_TRACE(TraceEvent::eDispatch, i, reinterpret_cast<uintptr_t>(this));
+			mTasks.makePreExe(i);
+			(static_cast<Caller_t *>(this)->*mFunctions[i])();
+			mTasks.makePostExe(i);
+			mCurrHandleIndex = max_index;
+			ioHasExe = true;
+
+			// handler budget consumed : resume from the next slot on the next cycle
+			if(SysKernelData::sIsBudgetExhausted())
+			{
+				mNextIndex = (static_cast<uint32_t>(i)+1 < task_count) ? i+1 : 0;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// the deadlines of all the tasks are compared at once,
+	// only the tasks whose deadlines are reached are evaluated
+	bool scheduleMask()
+	{
+		uint32_t mask[mask_words];
+		for(uint32_t k=0 ; k<mask_words ; k++)
+		{
+			mask[k] = mOccupied[k];
+		}
+		mTasks.getDeadlineMask(mask, SysKernelData::sGetTick());
+
+		bool hasExe = false;
+
+		// starts from the slot where the previous cycle stopped
+		index_type from = mNextIndex;
+		if(executeMask(mask, from, task_count, hasExe))
+		{
+			executeMask(mask, 0, from, hasExe);
+		}
+		return hasExe;
+	}
+
+	// the ready tasks are dispatched by rank, the lowest first, one rank per pass.
+	// The ready tasks left when the handler budget is consumed wait (see AgingPrio)
+	bool scheduleRank()
+	{
+		uint32_t ready[mask_words];
+		for(uint32_t w=0 ; w<mask_words ; w++)
+		{
+			ready[w] = 0;
+			for(uint32_t bits = mOccupied[w] ; bits ; bits &= bits-1)
+			{
+				const uint32_t i = w*32 + countTrailingZeros(bits);
+				if(mTasks.isExeReady(i)){ ready[w] |= static_cast<uint32_t>(1) << (i%32); }
+			}
+		}
+
+		bool hasExe = false;
+		bool isConsumed = false;
+		while(!isConsumed)
+		{
+			// lowest rank of the remaining ready tasks
+			uint32_t rank = ~static_cast<uint32_t>(0);
+			bool isReady = false;
+			for(uint32_t w=0 ; w<mask_words ; w++)
+			{
+				for(uint32_t bits = ready[w] ; bits ; bits &= bits-1)
+				{
+					const uint32_t r = mTasks.getDispatchRank(w*32 + countTrailingZeros(bits));
+					if(r < rank){ rank = r; }
+					isReady = true;
+				}
+			}
+			if(!isReady){ break; }
+
+			for(uint32_t w=0 ; w<mask_words && !isConsumed ; w++)
+			{
+				for(uint32_t bits = ready[w] ; bits ; bits &= bits-1)
+				{
+					const uint32_t i = w*32 + countTrailingZeros(bits);
+					if(mTasks.getDispatchRank(i) != rank){ continue; }
+					ready[w] &= ~(static_cast<uint32_t>(1) << (i%32));
+					if(!execute(i, hasExe))
+					{
+						isConsumed = true;
+						break;
+					}
+				}
+			}
+		}
+
+		// blocked by the tasks of lower rank
+		for(uint32_t w=0 ; w<mask_words ; w++)
+		{
+			for(uint32_t bits = ready[w] & mOccupied[w] ; bits ; bits &= bits-1)
+			{
+				mTasks.makeWait(w*32 + countTrailingZeros(bits));
+			}
+		}
+		return hasExe;
+	}
+
+	// executes the tasks set in inMask within [inFrom, inTo),
+	// a word of inMask is read when reached : with mOccupied, the slots occupied meanwhile
+	// are visited. scheduleMask passes a copy taken before the cycle, it skips them
+	// returns false when the handler budget is consumed
+	bool executeMask(const uint32_t *inMask, uint32_t inFrom, uint32_t inTo, bool &ioHasExe)
+	{
+		for(uint32_t w=inFrom/32 ; w*32<inTo ; w++)
+		{
+			uint32_t bits = inMask[w];
+			if(w == inFrom/32)
+			{
+				bits &= ~static_cast<uint32_t>(0)<<(inFrom%32);
+			}
+			while(bits)
+			{
+				uint32_t i = w*32 + countTrailingZeros(bits);
+				if(i >= inTo){ return true; }
+				bits &= bits-1;
+				if(!execute(i, ioHasExe)){ return false; }
+			}
+		}
+		return true;
+	}
+
+	// task function of the callable tasks
+	void executeCallable()
+	{
+		thisTaskHandle()->call();
+	}
+
+	virtual void catchException(const char *){}
 	
 	task_function_t mFunctions[task_count];
 
 	TaskHandle *mHandlePtr[task_count];
 
-	task_t mTasks[task_count];
+	// bit i is set when the slot i holds a task
+	uint32_t mOccupied[mask_words];
+
+	// the words before mFreeWord are full
+	uint32_t mFreeWord;
 
-	index_t mCurrHandleIndex;
+	storage_t mTasks;
+
+	index_type mCurrHandleIndex;
+
+	index_type mNextIndex;
 		
 };
 
 
-template<typename Caller_t, typename task_traits, index_t task_count>
-index_t TaskHandler<Caller_t, task_traits, task_count>::TaskItem::sCounterIndex = 0;
-
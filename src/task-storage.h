@@ -0,0 +1,350 @@
+/*
+ * Copyright (C) 2020 Thomas AUBERT <aubert.thms@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name ``Thomas AUBERT'' nor the name of any other
+ *    contributor may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 
+ * uCosmDev IS PROVIDED BY Thomas AUBERT ``AS IS'' AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL Thomas AUBERT OR ANY OTHER CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#pragma once
+
+
+#include "modules.h"
+
+#include "deadline-mask.h"
+
+
+
+// Storage of the tasks of a TaskHandler
+// gives access to the tasks and their modules by slot index
+
+
+
+// Array of structures (default) : each task holds all of its modules,
+// the TaskHandle points to the task itself
+template<typename Caller_t, typename task_modules, uint32_t task_count, typename index_type = index_t>
+struct TaskStorage
+{
+
+	struct TaskItem : public task_modules
+	{
+		constexpr TaskItem(): index(sCounterIndex++) {}
+		const index_type index;
+		static index_type sCounterIndex;
+	};
+
+	using TaskHandle = TaskItem*;
+
+	// the deadlines are interleaved with the other modules : no deadline mask
+	static const bool has_deadlines = false;
+
+	void getDeadlineMask(uint32_t *, tick_t) {}
+
+	bool isValid()
+	{
+		for(index_type i=0 ; i<task_count ; i++)
+		{
+			if(mTasks[i].index != i)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	TaskHandle getHandle(index_type i) { return &mTasks[i]; }
+	index_type getIndex(TaskHandle inHandle) { return inHandle->index; }
+
+	template<typename ...Args>
+	void init(index_type i, Args&&... inArgs) { mTasks[i].init(std::forward<Args>(inArgs)...); }
+	bool isExeReady(index_type i) { return mTasks[i].isExeReady(); }
+	bool isDelReady(index_type i) { return mTasks[i].isDelReady(); }
+	void makePreExe(index_type i) { mTasks[i].makePreExe(); }
+	void makePostExe(index_type i) { mTasks[i].makePostExe(); }
+	void makePreDel(index_type i) { mTasks[i].makePreDel(); }
+	bool getWakeTick(index_type i, tick_t inTick, tick_t &outWake) { return mTasks[i].getWakeTick(inTick, outWake); }
+	void snapshot(index_type i, SnapshotWriter &ioWriter) { mTasks[i].snapshot(ioWriter); }
+
+	// see Modules::getDispatchRank
+	static const bool has_priority = task_modules::has_priority;
+	uint32_t getDispatchRank(index_type i) { return mTasks[i].getDispatchRank(); }
+	void makeWait(index_type i) { mTasks[i].makeWait(); }
+
+private:
+
+	TaskItem mTasks[task_count];
+
+};
+
+
+template<typename Caller_t, typename task_modules, uint32_t task_count, typename index_type>
+index_type TaskStorage<Caller_t, task_modules, task_count, index_type>::TaskItem::sCounterIndex = 0;
+
+
+
+
+
+
+
+// Structure of arrays modules definition : the modules of all the tasks are stored
+// in one array per module, the readiness evaluation streams through dense arrays
+// instead of whole tasks.
+// The modules are reached from the handle by type : handle->get<Delay>()->setDelay(5)
+// The modules are not bound to a task (bind<void, 0>) : modules reaching their
+// sibling modules (Signal, MruList, Coroutine) require Modules<>.
+template<class ...ModuleCollection> 
+struct SoaModules
+{};
+
+
+
+template<typename Caller_t, uint32_t task_count, typename index_type, class ...ModuleCollection>
+struct TaskStorage<Caller_t, SoaModules<ModuleCollection...>, task_count, index_type>
+{
+
+	// module, not bound to any task
+	template<typename module_t>
+	using unbound_t = typename BindModule<module_t, void, 0>::type;
+
+	// module with its hooks exposed to the storage
+	template<typename module_t>
+	struct ModuleSlot : public unbound_t<module_t>
+	{
+		using unbound_t<module_t>::init;
+		using unbound_t<module_t>::isExeReady;
+		using unbound_t<module_t>::isDelReady;
+		using unbound_t<module_t>::makePreExe;
+		using unbound_t<module_t>::makePostExe;
+		using unbound_t<module_t>::makePreDel;
+
+		const tick_t *getDeadlines() const
+		{
+			return unbound_t<module_t>::getDeadline();
+		}
+	};
+
+	template<typename module_t>
+	struct ModuleArray
+	{
+		ModuleSlot<module_t> mSlots[task_count];
+	};
+
+	struct Arrays : public ModuleArray<ModuleCollection>...
+	{};
+
+	struct TaskRef
+	{
+		template<typename module_t>
+		unbound_t<module_t> *get()
+		{
+			return &storage->template getSlot<module_t>(index);
+		}
+
+		TaskStorage *storage;
+		index_type index;
+	};
+
+	using TaskHandle = TaskRef*;
+
+	// the deadline arrays are dense : the deadline modules are prefiltered by getDeadlineMask
+	static const bool has_deadlines = anyOf({false, HasDeadline<ModuleCollection>::value...});
+
+	// the dispatch order of the ready tasks is the slot order
+	static const bool has_priority = false;
+
+	static_assert(!anyOf({false, HasPriority<ModuleCollection>::value...}), "AgingPrio requires Modules<>");
+
+	uint32_t getDispatchRank(index_type) { return 0; }
+	void makeWait(index_type) {}
+
+	TaskStorage()
+	{
+		for(index_type i=0 ; i<task_count ; i++)
+		{
+			mRefs[i].storage = this;
+			mRefs[i].index = i;
+		}
+	}
+
+	bool isValid() { return true; }
+
+	TaskHandle getHandle(index_type i) { return &mRefs[i]; }
+	index_type getIndex(TaskHandle inHandle) { return inHandle->index; }
+
+	template<typename module_t>
+	ModuleSlot<module_t> &getSlot(index_type i)
+	{
+		return static_cast<ModuleArray<module_t> &>(mArrays).mSlots[i];
+	}
+
+	// clears the bits of the tasks whose deadline modules are not ready
+	void getDeadlineMask(uint32_t *ioMask, tick_t inTick)
+	{
+		uint8_t d[] = {(uint8_t)0, (andDeadlineMask<ModuleCollection>(ioMask, inTick), (uint8_t)0)...};
+		static_cast<void>(d); // avoid warning for unused variable
+	}
+
+	// see Modules::init
+	template<typename ...Args>
+	void init(index_type i, Args&&... inArgs)
+	{
+		initSlots(std::index_sequence_for<ModuleCollection...>(), i, std::forward<Args>(inArgs)...);
+	}
+
+	bool isExeReady(index_type i)
+	{
+		bool ready[] = {
+			true, (getSlot<ModuleCollection>(i).isExeReady())...
+		};
+		for(index_t k=0 ; k<sizeof(ready) ; k++)
+		{
+			if(!ready[k]){ return false; }
+		}
+		return true;
+	}
+
+	bool isDelReady(index_type i)
+	{
+		bool ready[] = {
+			true, (getSlot<ModuleCollection>(i).isDelReady())...
+		};
+		for(index_t k=0 ; k<sizeof(ready) ; k++)
+		{
+			if(!ready[k]){ return false; }
+		}
+		return true;
+	}
+
+	void makePreExe(index_type i)
+	{
+		uint8_t d[] = {(uint8_t)0, (getSlot<ModuleCollection>(i).makePreExe(), (uint8_t)0)...};
+		static_cast<void>(d); // avoid warning for unused variable
+	}
+
+	void makePostExe(index_type i)
+	{
+		uint8_t d[] = {(uint8_t)0, (getSlot<ModuleCollection>(i).makePostExe(), (uint8_t)0)...};
+		static_cast<void>(d); // avoid warning for unused variable
+	}
+
+	void makePreDel(index_type i)
+	{
+		uint8_t d[] = {(uint8_t)0, (getSlot<ModuleCollection>(i).makePreDel(), (uint8_t)0)...};
+		static_cast<void>(d); // avoid warning for unused variable
+	}
+
+	bool getWakeTick(index_type i, tick_t inTick, tick_t &outWake)
+	{
+		outWake = inTick;
+		bool timed[] = {
+			true, (getModuleWakeTick<ModuleCollection>(i, outWake))...
+		};
+		for(index_t k=0 ; k<sizeof(timed) ; k++)
+		{
+			if(!timed[k]){ return false; }
+		}
+		return true;
+	}
+
+	// see Modules::snapshot
+	void snapshot(index_type i, SnapshotWriter &ioWriter)
+	{
+		ioWriter.put8(sizeof...(ModuleCollection));
+		uint8_t d[] = {(uint8_t)0, (snapshotModule<unbound_t<ModuleCollection>>(getSlot<ModuleCollection>(i), ioWriter), (uint8_t)0)...};
+		static_cast<void>(d); // avoid warning for unused variable
+	}
+
+private:
+
+	static const uint32_t mask_words = (task_count+31)/32;
+
+	template<std::size_t ...I, typename ...Args>
+	void initSlots(std::index_sequence<I...>, index_type i, Args&&... inArgs)
+	{
+		static const std::size_t target = firstOf({decltype(takesInit<ModuleCollection, Args...>(0))::value...});
+		static_assert(sizeof...(Args) == 0 || target < sizeof...(ModuleCollection), "No module init takes these createTask arguments");
+
+		uint8_t d[] = {(uint8_t)0, (initSlot<ModuleCollection>(std::integral_constant<bool, I == target>(), i, std::forward<Args>(inArgs)...), (uint8_t)0)...};
+		static_cast<void>(d); // avoid warning for unused variable
+	}
+
+	template<typename module_t, typename ...Args>
+	static auto takesInit(int)
+		-> decltype(std::declval<ModuleSlot<module_t> &>().template init<Modules<ModuleCollection...>>(std::declval<Args>()...), std::true_type());
+
+	template<typename module_t, typename ...Args>
+	static std::false_type takesInit(long);
+
+	template<typename module_t, typename ...Args>
+	void initSlot(std::true_type, index_type i, Args&&... inArgs)
+	{
+		getSlot<module_t>(i).template init<Modules<ModuleCollection...>>(std::forward<Args>(inArgs)...);
+	}
+
+	template<typename module_t, typename ...Args>
+	void initSlot(std::false_type, index_type i, Args&&...)
+	{
+		getSlot<module_t>(i).template init<Modules<ModuleCollection...>>();
+	}
+
+	template<typename module_t>
+	typename std::enable_if<HasDeadline<module_t>::value>::type andDeadlineMask(uint32_t *ioMask, tick_t inTick)
+	{
+		static_assert(sizeof(ModuleSlot<module_t>)%sizeof(tick_t) == 0, "Deadline module size must be a multiple of tick_t");
+
+		uint32_t mask[mask_words] = {};
+		deadlineMask(getSlot<module_t>(0).getDeadlines(), sizeof(ModuleSlot<module_t>)/sizeof(tick_t), task_count, inTick, mask);
+
+		for(uint32_t k=0 ; k<mask_words ; k++)
+		{
+			ioMask[k] &= mask[k];
+		}
+	}
+
+	template<typename module_t>
+	typename std::enable_if<!HasDeadline<module_t>::value>::type andDeadlineMask(uint32_t *, tick_t) {}
+
+	// see Modules::getWakeTick
+	template<typename module_t>
+	typename std::enable_if<HasDeadline<module_t>::value, bool>::type getModuleWakeTick(index_type i, tick_t &ioWake)
+	{
+		if(!getSlot<module_t>(i).isExeReady())
+		{
+			ioWake = getLatestTick(ioWake, *getSlot<module_t>(i).getDeadlines());
+		}
+		return true;
+	}
+
+	template<typename module_t>
+	typename std::enable_if<!HasDeadline<module_t>::value, bool>::type getModuleWakeTick(index_type i, tick_t &)
+	{
+		return IsPolled<module_t>::value || getSlot<module_t>(i).isExeReady();
+	}
+
+	Arrays mArrays;
+
+	TaskRef mRefs[task_count];
+
+};
@@ -0,0 +1,407 @@
+/*
+ * Copyright (C) 2020 Thomas AUBERT <aubert.thms@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name ``Thomas AUBERT'' nor the name of any other
+ *    contributor may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 
+ * uCosmDev IS PROVIDED BY Thomas AUBERT ``AS IS'' AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL Thomas AUBERT OR ANY OTHER CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#pragma once
+
+
+#include "uscosm-sys-data.h"
+
+#include "utils.h"
+
+
+
+// identifies a started timer, 0 : invalid
+using timer_id_t = uint32_t;
+
+
+// Software timers without task slot : the callbacks are called from the kernel cycle,
+// the service is registered as a handler :
+//
+//	TimerService<64> timers;
+//	kernel.addHandler(&timers);
+//
+//	timer_id_t t = timers.startOneShot(100, [&]{ timeout(); });
+//	timers.cancel(t);
+//
+// The timers are stored in a static hierarchical timing wheel : 3 levels of slot_count slots,
+// the slots of a level span slot_count times the ticks of the slots of the level below.
+// A slot of an upper level is cascaded into the lower levels when the wheel below wraps.
+// The start and the cancel are O(1), a cycle visits one slot per elapsed tick whatever the number
+// of pending timers, the timers beyond the range of the wheel are cascaded once per turn.
+// timer_count : max number of simultaneous timers
+// callback_capacity : bytes of the callback captures (see InplaceFunction)
+template<uint16_t timer_count, uint16_t slot_count = 64, uint16_t callback_capacity = 2*sizeof(void *)>
+class TimerService : public iScheduler
+{
+
+	static_assert(timer_count && timer_count < 0xFFFF, "Timer count error");
+	static_assert(slot_count > 1 && slot_count <= 1024 && !(slot_count & (slot_count-1)), "Slot count must be a power of two up to 1024");
+
+	static const uint8_t level_count = 3;
+
+	static const uint8_t slot_bits = (slot_count > 512) ? 10 : (slot_count > 256) ? 9 : (slot_count > 128) ? 8 :
+		(slot_count > 64) ? 7 : (slot_count > 32) ? 6 : (slot_count > 16) ? 5 : (slot_count > 8) ? 4 :
+		(slot_count > 4) ? 3 : (slot_count > 2) ? 2 : 1;
+
+	// ticks covered by the wheel
+	static const tick_t wheel_range = static_cast<tick_t>(1) << (slot_bits*level_count);
+
+	struct Link
+	{
+		Link *prev;
+		Link *next;
+	};
+
+	struct Timer : public Link
+	{
+		enum eState:uint8_t
+		{
+			eFree = 0,
+			eActive,
+			eFiring,	// the callback is running
+			eCancelled	// cancelled by its own callback
+		};
+
+		tick_t expiry;
+		tick_t period;		// 0 : one shot
+		uint16_t generation;
+		eState state;
+		InplaceFunction<callback_capacity> callback;
+	};
+
+public:
+
+	TimerService() : mCurrent(0), mActiveCount(0), mStarted(false)
+	{
+		for(uint8_t l=0 ; l<level_count ; l++)
+		{
+			for(uint16_t s=0 ; s<slot_count ; s++)
+			{
+				mSlots[l][s].prev = mSlots[l][s].next = &mSlots[l][s];
+			}
+		}
+		mFree.prev = mFree.next = &mFree;
+		for(uint16_t i=0 ; i<timer_count ; i++)
+		{
+			mTimers[i].generation = 0;
+			mTimers[i].state = Timer::eFree;
+			insert(&mFree, &mTimers[i]);
+		}
+	}
+
+	// calls inCallback once, inDelay ticks from now
+	template<typename F>
+	timer_id_t startOneShot(tick_t inDelay, F &&inCallback)
+	{
+		return start(inDelay, 0, std::forward<F>(inCallback));
+	}
+
+	// calls inCallback every inPeriod ticks until cancelled, missed periods are skipped
+	template<typename F>
+	timer_id_t startPeriodic(tick_t inPeriod, F &&inCallback)
+	{
+		if(!inPeriod){ return 0; }
+		return start(inPeriod, inPeriod, std::forward<F>(inCallback));
+	}
+
+	// a timer can cancel itself from its callback
+	bool cancel(timer_id_t inId)
+	{
+		Timer *t = getTimer(inId);
+		if(!t){ return false; }
+
+		if(t->state == Timer::eFiring)
+		{
+			t->state = Timer::eCancelled;
+			return true;
+		}
+		unlink(t);
+		release(t);
+		return true;
+	}
+
+	bool isActive(timer_id_t inId)
+	{
+		return getTimer(inId) != nullptr;
+	}
+
+	uint16_t getActiveCount() const
+	{
+		return mActiveCount;
+	}
+
+	// calls the callbacks of the timers expired since the previous cycle
+	bool schedule(tick_t = 0) final
+	{
+		const tick_t now = SysKernelData::sGetTick();
+		if(!mStarted || !mActiveCount)
+		{
+			mStarted = true;
+			mCurrent = now;
+			return false;
+		}
+
+		// long gap (sleep) : the timers are armed again from the previous tick
+		if(now - mCurrent > slot_count)
+		{
+			rebase(now-1);
+		}
+
+		bool hasExe = false;
+		while(mCurrent != now)
+		{
+			mCurrent++;
+			cascade();
+			hasExe |= expire(mCurrent);
+		}
+		return hasExe;
+	}
+
+	// tick of the next non empty slot of the first level,
+	// or the next cascade when the first level is empty up to its end
+	bool getWakeTick(tick_t inTick, tick_t &outWake) final
+	{
+		if(!mActiveCount){ return false; }
+		if(!mStarted)
+		{
+			outWake = inTick;
+			return true;
+		}
+		const tick_t turnEnd = (mCurrent | (slot_count-1)) + 1;
+		for(tick_t tick = mCurrent+1 ; tick != turnEnd ; tick++)
+		{
+			const Link *slot = &mSlots[0][tick & (slot_count-1)];
+			if(slot->next != slot)
+			{
+				outWake = tick;
+				return true;
+			}
+		}
+		outWake = turnEnd;
+		return true;
+	}
+
+private:
+
+	template<typename F>
+	timer_id_t start(tick_t inDelay, tick_t inPeriod, F &&inCallback)
+	{
+		if(mFree.next == &mFree){ return 0; }
+
+		const tick_t now = SysKernelData::sGetTick();
+		if(!mStarted || !mActiveCount)
+		{
+			mStarted = true;
+			mCurrent = now;
+		}
+
+		Timer *t = static_cast<Timer *>(mFree.next);
+		unlink(t);
+		t->callback.assign(std::forward<F>(inCallback));
+		t->period = inPeriod;
+		t->state = Timer::eActive;
+		mActiveCount++;
+		arm(t, now + inDelay);
+
+		return (static_cast<timer_id_t>(t->generation) << 16) | static_cast<timer_id_t>(t - mTimers + 1);
+	}
+
+	// active timer of inId, nullptr if the timer has expired or has been cancelled
+	Timer *getTimer(timer_id_t inId)
+	{
+		const uint32_t index = (inId & 0xFFFF) - 1;
+		if(index >= timer_count){ return nullptr; }
+		Timer *t = &mTimers[index];
+		if(t->generation != (inId >> 16) || t->state == Timer::eFree || t->state == Timer::eCancelled)
+		{
+			return nullptr;
+		}
+		return t;
+	}
+
+	// the slot of the current tick has been visited : the timer expires at the next tick at the earliest
+	void arm(Timer *ioTimer, tick_t inExpiry)
+	{
+		ioTimer->expiry = inExpiry;
+		place(ioTimer, mCurrent+1);
+	}
+
+	// slot of the level whose span holds the expiry, not before inFirstTick
+	void place(Timer *ioTimer, tick_t inFirstTick)
+	{
+		tick_t tick = isTickReached(inFirstTick, ioTimer->expiry) ? inFirstTick : ioTimer->expiry;
+		tick_t delta = tick - mCurrent;
+		if(delta >= wheel_range)
+		{
+			// beyond the wheel : last slot of the upper level, cascaded again later
+			tick = mCurrent + wheel_range - 1;
+			delta = wheel_range - 1;
+		}
+		uint8_t level = 0;
+		while(delta >= (static_cast<tick_t>(1) << (slot_bits*(level+1))))
+		{
+			level++;
+		}
+		insert(&mSlots[level][(tick >> (slot_bits*level)) & (slot_count-1)], ioTimer);
+	}
+
+	// the lower levels wrapped : the timers of the reached slots of the upper levels are placed again,
+	// before the first level slot of the current tick is visited
+	void cascade()
+	{
+		for(uint8_t level=1 ; level<level_count ; level++)
+		{
+			if(mCurrent & ((static_cast<tick_t>(1) << (slot_bits*level)) - 1))
+			{
+				return;
+			}
+			Link pending;
+			detach(&mSlots[level][(mCurrent >> (slot_bits*level)) & (slot_count-1)], &pending);
+			while(pending.next != &pending)
+			{
+				Timer *t = static_cast<Timer *>(pending.next);
+				unlink(t);
+				place(t, mCurrent);
+			}
+		}
+	}
+
+	// every timer is placed again relatively to inTick
+	void rebase(tick_t inTick)
+	{
+		Link pending;
+		pending.prev = pending.next = &pending;
+		for(uint8_t l=0 ; l<level_count ; l++)
+		{
+			for(uint16_t s=0 ; s<slot_count ; s++)
+			{
+				Link *slot = &mSlots[l][s];
+				while(slot->next != slot)
+				{
+					Link *t = slot->next;
+					unlink(t);
+					insert(&pending, t);
+				}
+			}
+		}
+		mCurrent = inTick;
+		while(pending.next != &pending)
+		{
+			Timer *t = static_cast<Timer *>(pending.next);
+			unlink(t);
+			place(t, mCurrent+1);
+		}
+	}
+
+	// calls the callbacks of the timers of the first level slot of inTick
+	bool expire(tick_t inTick)
+	{
+		Link *slot = &mSlots[0][inTick & (slot_count-1)];
+		if(slot->next == slot){ return false; }
+
+		// the slot is detached : the callbacks may start and cancel timers
+		Link pending;
+		detach(slot, &pending);
+
+		bool hasExe = false;
+		while(pending.next != &pending)
+		{
+			Timer *t = static_cast<Timer *>(pending.next);
+			unlink(t);
+
+			t->state = Timer::eFiring;
+			t->callback();
+			hasExe = true;
+
+			if(t->state == Timer::eFiring && t->period)
+			{
+				t->state = Timer::eActive;
+				const tick_t next = t->expiry + t->period;
+				arm(t, isTickReached(inTick, next) ? inTick + t->period : next);
+			}else{
+				release(t);
+			}
+		}
+		return hasExe;
+	}
+
+	void release(Timer *ioTimer)
+	{
+		ioTimer->callback.reset();
+		ioTimer->state = Timer::eFree;
+		ioTimer->generation++;
+		mActiveCount--;
+		insert(&mFree, ioTimer);
+	}
+
+	// moves the list of ioHead to outPending
+	static void detach(Link *ioHead, Link *outPending)
+	{
+		if(ioHead->next == ioHead)
+		{
+			outPending->prev = outPending->next = outPending;
+			return;
+		}
+		outPending->next = ioHead->next;
+		outPending->prev = ioHead->prev;
+		outPending->next->prev = outPending;
+		outPending->prev->next = outPending;
+		ioHead->prev = ioHead->next = ioHead;
+	}
+
+	static void insert(Link *ioHead, Link *ioLink)
+	{
+		ioLink->prev = ioHead->prev;
+		ioLink->next = ioHead;
+		ioHead->prev->next = ioLink;
+		ioHead->prev = ioLink;
+	}
+
+	static void unlink(Link *ioLink)
+	{
+		ioLink->prev->next = ioLink->next;
+		ioLink->next->prev = ioLink->prev;
+		ioLink->prev = ioLink->next = ioLink;
+	}
+
+	Timer mTimers[timer_count];
+
+	Link mSlots[level_count][slot_count];
+
+	Link mFree;
+
+	// last tick visited
+	tick_t mCurrent;
+
+	uint16_t mActiveCount;
+
+	bool mStarted;
+
+};
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2020 Thomas AUBERT <aubert.thms@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name ``Thomas AUBERT'' nor the name of any other
+ *    contributor may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 
+ * uCosmDev IS PROVIDED BY Thomas AUBERT ``AS IS'' AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL Thomas AUBERT OR ANY OTHER CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+
+#pragma once
+
+#include "stdint.h"
+
+
+
+
+// Trace points of the scheduler :
+//	UCOSM_TRACE(event, arg0, arg1)
+// expands to nothing unless a trace backend defines it before the scheduler headers are
+// included (see linux/flight-recorder.h), the trace points cost nothing otherwise.
+//
+// event (arg0, arg1) :
+//  - eDispatch      : a task is executed (task index, handler address)
+//  - eCycle         : end of a kernel cycle which executed a task or exceeded the overload
+//                     threshold (task executed, cycle duration)
+//  - eOverload      : change of the kernel overload state (overloaded, cycle duration)
+//  - eOverrun       : PeriodicStats release started more than one period late (missed releases, lateness)
+//  - eSignalDrop    : Signal sent to a full fifo (fifo size, receiver address)
+//  - ePoolExhausted : MemPool32 allocation failed (pool size, pool address)
+struct TraceEvent
+{
+	enum eEvent:uint16_t
+	{
+		eDispatch = 1,
+		eCycle,
+		eOverload,
+		eOverrun,
+		eSignalDrop,
+		ePoolExhausted
+	};
+};
+
+
+#ifndef UCOSM_TRACE
+#define UCOSM_TRACE(inEvent, inArg0, inArg1)
+#endif
+
@@ -30,31 +30,102 @@
 
 #include "stdint.h"
 #include <limits>
+#include <type_traits>
+
+#include "snapshot.h"
+
+#include "trace.h"
 
 
 using tick_t = uint32_t;
 
 
+// kernel cycle counter
+using cycle_t = uint32_t;
+
+
 using index_t = uint8_t;
 
 
 const index_t max_index = std::numeric_limits<index_t>::max();
 
 
+// smallest index type addressing count slots : TaskHandler and Kernel default,
+// the max value of the type is kept as the invalid index
+template<uint32_t count>
+struct IndexType
+{
+	using type = typename std::conditional<(count < 0xFF-1), uint8_t,
+		typename std::conditional<(count < 0xFFFF-1), uint16_t, uint32_t>::type>::type;
+};
+
+
+// wraparound safe comparison : true when inTick is at or after inStamp,
+// valid while both are less than half of the tick range apart
+inline bool isTickReached(tick_t inTick, tick_t inStamp)
+{
+	return static_cast<std::make_signed<tick_t>::type>(inTick - inStamp) >= 0;
+}
+
+
+// earliest and latest of two ticks, wraparound safe
+inline tick_t getEarliestTick(tick_t inTickA, tick_t inTickB)
+{
+	return isTickReached(inTickA, inTickB) ? inTickB : inTickA;
+}
+
+inline tick_t getLatestTick(tick_t inTickA, tick_t inTickB)
+{
+	return isTickReached(inTickA, inTickB) ? inTickA : inTickB;
+}
+
+
 struct iScheduler
 {
 	virtual bool schedule(tick_t t = 0) = 0;
+
+	// earliest tick at which a task may be ready, evaluated at inTick,
+	// returns false when only an event (fd, other task, interrupt) can make a task ready.
+	// By default the scheduler is polled.
+	virtual bool getWakeTick(tick_t inTick, tick_t &outWake)
+	{
+		outWake = inTick;
+		return true;
+	}
+
+	// writes the state of the scheduler, see snapshot.h
+	virtual void snapshot(SnapshotWriter &ioWriter)
+	{
+		ioWriter.put8(SnapshotWriter::eNoSnapshot);
+	}
 };
 
 
 struct SysKernelData
 {
-	static uint8_t sCnt;
+	static cycle_t sCnt;
 	static tick_t (*sGetTick)();
 	static iScheduler *sMaster;
+
+	// time budget of the handler currently scheduled, 0 : unlimited
+	static tick_t sBudget;
+	static tick_t sBudgetStart;
+
+	static bool sIsBudgetExhausted()
+	{
+		return sBudget && ( (sGetTick() - sBudgetStart) >= sBudget );
+	}
+
+	// set by the kernel overload control, the Criticality module sheds the tasks meanwhile
+	static bool sIsOverloaded;
 };
 
 
-uint8_t SysKernelData::sCnt;
+cycle_t SysKernelData::sCnt = 0;
+
+tick_t SysKernelData::sBudget = 0;
+
+tick_t SysKernelData::sBudgetStart = 0;
 
+bool SysKernelData::sIsOverloaded = false;
 
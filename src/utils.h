@@ -28,6 +28,12 @@
 
 #pragma once
 
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
 
 
 
@@ -60,6 +66,11 @@ struct Fifo
 	{
 		return (mIndex==Size);
 	}
+
+	uint16_t getCount() const
+	{
+		return mIndex;
+	}
 	
 private :
 
@@ -80,6 +91,107 @@ private :
 
 
 
+// contiguous elements, i.e. a window on a buffer
+template<typename T>
+struct Span
+{
+	T *data;
+	uint16_t size;
+
+	bool isEmpty() const
+	{
+		return !size;
+	}
+
+	T &operator[](uint16_t inIdx) const
+	{
+		return data[inIdx];
+	}
+};
+
+
+
+
+
+// void() callable stored in a fixed buffer of capacity bytes : function pointer, functor or
+// capturing lambda, no heap. The call goes through a single trampoline.
+template<uint16_t capacity>
+class InplaceFunction
+{
+
+public:
+
+	InplaceFunction() : mInvoke(nullptr), mDestroy(nullptr)
+	{}
+
+	~InplaceFunction()
+	{
+		reset();
+	}
+
+	InplaceFunction(const InplaceFunction &) = delete;
+	InplaceFunction &operator=(const InplaceFunction &) = delete;
+
+	// constructs the callable in the buffer, the previous one is destroyed
+	template<typename F>
+	void assign(F &&inCallable)
+	{
+		using callable_t = typename std::decay<F>::type;
+		static_assert(sizeof(callable_t) <= capacity, "Callable exceeds the InplaceFunction capacity");
+		static_assert(alignof(callable_t) <= alignof(std::max_align_t), "Callable alignment error");
+
+		reset();
+		new (mStorage) callable_t(std::forward<F>(inCallable));
+		mInvoke = &invoke<callable_t>;
+		mDestroy = std::is_trivially_destructible<callable_t>::value ? nullptr : &destroy<callable_t>;
+	}
+
+	void reset()
+	{
+		if(mDestroy)
+		{
+			mDestroy(mStorage);
+		}
+		mInvoke = nullptr;
+		mDestroy = nullptr;
+	}
+
+	explicit operator bool() const
+	{
+		return mInvoke != nullptr;
+	}
+
+	void operator()()
+	{
+		mInvoke(mStorage);
+	}
+
+private:
+
+	template<typename callable_t>
+	static void invoke(void *inStorage)
+	{
+		(*static_cast<callable_t *>(inStorage))();
+	}
+
+	template<typename callable_t>
+	static void destroy(void *inStorage)
+	{
+		static_cast<callable_t *>(inStorage)->~callable_t();
+	}
+
+	alignas(std::max_align_t) uint8_t mStorage[capacity];
+
+	void (*mInvoke)(void *);
+
+	void (*mDestroy)(void *);
+
+};
+
+
+
+
+
 template<typename Derived>
 struct ObjectCounter
 {
@@ -96,3 +208,54 @@ index_t ObjectCounter<Derived>::sCount = 0;
 
 
 
+
+// index of the lowest bit set, inValue must not be null
+inline uint8_t countTrailingZeros(uint32_t inValue)
+{
+#if defined(__GNUC__)
+	return __builtin_ctz(inValue);
+#else
+	uint8_t n = 0;
+	while(!(inValue&1)){ inValue >>= 1; n++; }
+	return n;
+#endif
+}
+
+
+
+// true if at least one of the values is true
+constexpr bool anyOf(std::initializer_list<bool> inValues)
+{
+	for(bool v : inValues)
+	{
+		if(v){ return true; }
+	}
+	return false;
+}
+
+// index of the first true value, the count of values if none
+constexpr std::size_t firstOf(std::initializer_list<bool> inValues)
+{
+	std::size_t i = 0;
+	for(bool v : inValues)
+	{
+		if(v){ return i; }
+		i++;
+	}
+	return i;
+}
+
+
+
+// void if the types are well formed, used for detection
+template<typename... T>
+struct MakeVoid
+{
+	using type = void;
+};
+
+template<typename... T>
+using VoidT = typename MakeVoid<T...>::type;
+
+
+
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2020 Thomas AUBERT <aubert.thms@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name ``Thomas AUBERT'' nor the name of any other
+ *    contributor may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 
+ * uCosmDev IS PROVIDED BY Thomas AUBERT ``AS IS'' AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL Thomas AUBERT OR ANY OTHER CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+
+
+// Post-mortem reader of a flight recorder file (see src/linux/flight-recorder.h),
+// prints the events of the last seconds of the recording, the oldest first :
+//
+//	g++ -std=c++14 tools/flight-dump.cc -o flight-dump
+//	./flight-dump /var/tmp/ucosm.trace 5
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../src/linux/flight-recorder.h"
+
+
+
+
+static const char *sEventNames[] = {
+	"?", "dispatch", "cycle", "overload", "overrun", "signal-drop", "pool-exhausted"
+};
+
+// names of the arguments, arg1 is printed in hexadecimal when it is an address
+struct EventArgs
+{
+	const char *arg0;
+	const char *arg1;
+	bool isAddress;
+};
+
+static const EventArgs sEventArgs[] = {
+	{"arg0", "arg1", true},
+	{"task", "handler", true},
+	{"exe", "duration", false},
+	{"overloaded", "duration", false},
+	{"missed", "lateness", false},
+	{"fifo", "receiver", true},
+	{"pool", "pool", true}
+};
+
+
+
+
+int main(int argc, char **argv)
+{
+	if(argc < 2)
+	{
+		fprintf(stderr, "usage : %s file [seconds]\n", argv[0]);
+		return 1;
+	}
+	const uint32_t seconds = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 0;
+
+	FILE *file = fopen(argv[1], "rb");
+	if(!file)
+	{
+		fprintf(stderr, "can't open %s\n", argv[1]);
+		return 1;
+	}
+
+	ucosm_linux::FlightHeader header;
+	if(fread(&header, sizeof(header), 1, file) != 1 || header.magic != ucosm_linux::FlightHeader::magic_value ||
+		!header.recordCount)
+	{
+		fprintf(stderr, "not a flight recorder file\n");
+		return 1;
+	}
+	if(header.version != ucosm_linux::FlightHeader::version_value || header.recordSize != sizeof(ucosm_linux::FlightRecord))
+	{
+		fprintf(stderr, "flight recorder file version %u, version %u expected\n", header.version,
+			ucosm_linux::FlightHeader::version_value);
+		return 1;
+	}
+
+	std::vector<ucosm_linux::FlightRecord> records(header.recordCount);
+	if(fread(records.data(), sizeof(ucosm_linux::FlightRecord), header.recordCount, file) != header.recordCount)
+	{
+		fprintf(stderr, "truncated file\n");
+		return 1;
+	}
+	fclose(file);
+
+	const uint64_t count = (header.written < header.recordCount) ? header.written : header.recordCount;
+	printf("%llu events written, %llu kept\n", (unsigned long long)header.written, (unsigned long long)count);
+	if(!count){ return 0; }
+
+	const uint64_t first = header.written - count;
+	const uint32_t lastTick = records[(header.written-1) % header.recordCount].tick;
+	const uint32_t window = seconds*header.ticksPerSecond;
+
+	for(uint64_t k=first ; k<header.written ; k++)
+	{
+		const ucosm_linux::FlightRecord &r = records[k % header.recordCount];
+		const uint32_t age = lastTick - r.tick;
+		if(seconds && age > window){ continue; }
+
+		const uint16_t e = (r.event < sizeof(sEventNames)/sizeof(sEventNames[0])) ? r.event : 0;
+		printf("%10u  cycle %10u  %-14s %s=%u ", r.tick, r.cycle, sEventNames[e], sEventArgs[e].arg0, r.arg0);
+		printf(sEventArgs[e].isAddress ? "%s=0x%llx\n" : "%s=%llu\n", sEventArgs[e].arg1, (unsigned long long)r.arg1);
+	}
+
+	return 0;
+}
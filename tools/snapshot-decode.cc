@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2020 Thomas AUBERT <aubert.thms@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name ``Thomas AUBERT'' nor the name of any other
+ *    contributor may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 
+ * uCosmDev IS PROVIDED BY Thomas AUBERT ``AS IS'' AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL Thomas AUBERT OR ANY OTHER CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+// Decoder of the scheduler snapshots (see src/snapshot.h) :
+//
+//	g++ -std=c++14 tools/snapshot-decode.cc -o snapshot-decode
+//	./snapshot-decode snapshot.bin
+//	./snapshot-decode < snapshot.bin
+
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+
+#include "../src/snapshot.h"
+
+
+
+
+// field list of a module state :
+//  'b' u8, 'w' u16, 'l' u32, 'x' u32 in hexadecimal, 'd' u32 deadline printed relative to the snapshot tick,
+//  'h' remaining bytes as u16 histogram
+struct ModuleFormat
+{
+	uint8_t id;
+	const char *name;
+	const char *fields;
+	const char *names[8];
+};
+
+static const ModuleFormat sFormats[] = {
+	{SnapshotWriter::ePrio,			"Prio",			"bbl",		{"priority", "catch_up", "next_cycle"}},
+	{SnapshotWriter::eStatus,		"Status",		"b",		{"status"}},
+	{SnapshotWriter::eStatusNotify,	"StatusNotify",	"b",		{"status"}},
+	{SnapshotWriter::eGroup,		"Group",		"b",		{"group"}},
+	{SnapshotWriter::eDelay,		"Delay",		"d",		{"deadline"}},
+	{SnapshotWriter::ePeriodic,		"Periodic",		"dwb",		{"deadline", "period", "catch_up"}},
+	{SnapshotWriter::ePeriodicStats,"PeriodicStats","dwblwwh",	{"deadline", "period", "catch_up", "max_jitter", "overruns", "skipped", "histogram"}},
+	{SnapshotWriter::eBudget,		"Budget",		"ll",		{"budget", "consumed"}},
+	{SnapshotWriter::eLoad,			"Load",			"ll",		{"busy", "longest"}},
+	{SnapshotWriter::eSignal,		"Signal",		"ww",		{"count", "capacity"}},
+	{SnapshotWriter::eMemPool32,	"MemPool32",	"bx",		{"allocation", "pool_map"}},
+	{SnapshotWriter::eParent,		"Parent",		"bb",		{"is_parent", "linked"}},
+	{SnapshotWriter::eDataflow,		"Dataflow",		"xx",		{"required", "arrived"}},
+	{SnapshotWriter::eMruList,		"MruList",		"",			{}},
+	{SnapshotWriter::eIoWait,		"IoWait",		"lx",		{"fd", "events"}},
+	{SnapshotWriter::eTimeSlice,	"TimeSlice",	"ll",		{"slice", "cursor"}},
+	{SnapshotWriter::eCriticality,	"Criticality",	"b",		{"class"}},
+	{SnapshotWriter::ePingPongBuffer,	"PingPongBuffer",	"bbb",	{"front", "back", "state"}},
+	{SnapshotWriter::eStreamBuffer,	"StreamBuffer",	"www",		{"count", "trigger", "size"}},
+	{SnapshotWriter::eAgingPrio,	"AgingPrio",	"bblw",		{"priority", "catch_up", "next_cycle", "age"}},
+};
+
+
+
+struct Reader
+{
+	const std::vector<uint8_t> &data;
+	size_t pos;
+	bool error;
+
+	uint32_t get(uint8_t inSize)
+	{
+		uint32_t v = 0;
+		for(uint8_t i=0 ; i<inSize ; i++)
+		{
+			if(pos >= data.size()){ error = true; return 0; }
+			v |= static_cast<uint32_t>(data[pos++]) << (8*i);
+		}
+		return v;
+	}
+
+	uint64_t getAddress(uint8_t inSize)
+	{
+		uint64_t v = 0;
+		for(uint8_t i=0 ; i<inSize ; i++)
+		{
+			if(pos >= data.size()){ error = true; return 0; }
+			v |= static_cast<uint64_t>(data[pos++]) << (8*i);
+		}
+		return v;
+	}
+};
+
+static uint8_t sPointerSize;
+static uint32_t sTick;
+
+
+
+static void decodeModule(Reader &ioReader, const char *inIndent)
+{
+	uint8_t id = ioReader.get(1);
+	uint16_t length = ioReader.get(2);
+	size_t end = ioReader.pos + length;
+
+	const ModuleFormat *format = nullptr;
+	for(const ModuleFormat &f : sFormats)
+	{
+		if(f.id == id && id != SnapshotWriter::eRaw){ format = &f; }
+	}
+
+	if(!format)
+	{
+		printf("%smodule (raw, %u bytes) :", inIndent, length);
+		for(uint16_t i=0 ; i<length ; i++){ printf(" %02x", ioReader.get(1)); }
+		printf("\n");
+		return;
+	}
+
+	printf("%s%s :", inIndent, format->name);
+	for(uint8_t k=0 ; format->fields[k] && ioReader.pos < end ; k++)
+	{
+		const char *name = format->names[k];
+		switch(format->fields[k])
+		{
+			case 'b': printf(" %s=%u", name, ioReader.get(1)); break;
+			case 'w': printf(" %s=%u", name, ioReader.get(2)); break;
+			case 'l': printf(" %s=%u", name, ioReader.get(4)); break;
+			case 'x': printf(" %s=0x%x", name, ioReader.get(4)); break;
+			case 'd': printf(" %s=%+d", name, static_cast<int32_t>(ioReader.get(4) - sTick)); break;
+			case 'h':
+				printf(" %s=[", name);
+				while(ioReader.pos + 1 < end){ printf(" %u", ioReader.get(2)); }
+				printf(" ]");
+				break;
+		}
+	}
+	printf("\n");
+	ioReader.pos = end;
+}
+
+static void decodeModules(Reader &ioReader, const char *inIndent)
+{
+	uint8_t count = ioReader.get(1);
+	for(uint8_t m=0 ; m<count && !ioReader.error ; m++)
+	{
+		decodeModule(ioReader, inIndent);
+	}
+}
+
+static void decodeScheduler(Reader &ioReader, int inDepth);
+
+static void decodeKernel(Reader &ioReader, int inDepth)
+{
+	uint8_t indexSize = ioReader.get(1);
+	uint32_t count = ioReader.get(indexSize);
+	uint32_t cycles = ioReader.get(4);
+	uint32_t idle = ioReader.get(4);
+	uint32_t busy = ioReader.get(4);
+	uint32_t longest = ioReader.get(4);
+	uint32_t period = ioReader.get(4);
+	printf("%*skernel : %u handlers, stats : cycles=%u idle=%u busy=%u longest=%u period=%u\n", 
+		inDepth*2, "", count, cycles, idle, busy, longest, period);
+
+	for(uint32_t h=0 ; h<count && !ioReader.error ; h++)
+	{
+		printf("%*shandler %u\n", inDepth*2+2, "", h);
+		decodeModules(ioReader, "        ");
+		decodeScheduler(ioReader, inDepth+2);
+	}
+}
+
+static void decodeTaskHandler(Reader &ioReader, int inDepth)
+{
+	uint8_t indexSize = ioReader.get(1);
+	uint32_t count = ioReader.get(indexSize);
+	uint32_t current = ioReader.get(indexSize);
+	uint32_t next = ioReader.get(indexSize);
+	const uint32_t noIndex = (indexSize < 4) ? (1UL << (8*indexSize)) - 1 : 0xFFFFFFFF;
+	printf("%*stask handler : %u slots, ", inDepth*2, "", count);
+	if(current != noIndex){ printf("running task %u, ", current); }
+	printf("next slot %u\n", next);
+
+	for(uint32_t t=0 ; t<count && !ioReader.error ; t++)
+	{
+		if(!ioReader.get(1))
+		{
+			printf("%*s[%u] free\n", inDepth*2+2, "", t);
+			continue;
+		}
+		printf("%*s[%u] function 0x%llx\n", inDepth*2+2, "", t, 
+			static_cast<unsigned long long>(ioReader.getAddress(sPointerSize)));
+		decodeModules(ioReader, "            ");
+	}
+}
+
+static void decodeScheduler(Reader &ioReader, int inDepth)
+{
+	switch(ioReader.get(1))
+	{
+		case SnapshotWriter::eKernel: decodeKernel(ioReader, inDepth); break;
+		case SnapshotWriter::eTaskHandler: decodeTaskHandler(ioReader, inDepth); break;
+		case SnapshotWriter::eNoSnapshot: printf("%*sscheduler without snapshot\n", inDepth*2, ""); break;
+		default: ioReader.error = true; break;
+	}
+}
+
+
+
+int main(int argc, char **argv)
+{
+	FILE *file = (argc > 1) ? fopen(argv[1], "rb") : stdin;
+	if(!file)
+	{
+		fprintf(stderr, "can't open %s\n", argv[1]);
+		return 1;
+	}
+
+	std::vector<uint8_t> data;
+	int c;
+	while((c = fgetc(file)) != EOF){ data.push_back(static_cast<uint8_t>(c)); }
+
+	Reader reader{data, 0, false};
+
+	if(reader.get(1) != 'u' || reader.get(1) != 'C' || reader.get(1) != 'S' || reader.get(1) != 'M')
+	{
+		fprintf(stderr, "not a uCoSM snapshot\n");
+		return 1;
+	}
+	uint8_t version = reader.get(1);
+	if(version != SnapshotWriter::version)
+	{
+		fprintf(stderr, "unsupported snapshot version %u\n", version);
+		return 1;
+	}
+	sPointerSize = reader.get(1);
+	sTick = reader.get(4);
+	uint32_t cycle = reader.get(4);
+
+	printf("snapshot v%u : tick=%u cycle=%u, %zu bytes\n", version, sTick, cycle, data.size());
+	decodeScheduler(reader, 0);
+
+	if(reader.error)
+	{
+		fprintf(stderr, "truncated or corrupted snapshot\n");
+		return 1;
+	}
+	return 0;
+}